@@ -14,13 +14,13 @@
  * need to allocate memory for each pin (atmega2560 would mean > 50 pins) wich would be quite a lot of scarce RAM.
  * PinMode is used to actually set the mode for the pin.
  * digtalRead()s and digitalWrite()s map the pin to the array index an the values are either set or read
- * from pinVAL which is mapped parallel to pinMap.
+ * from the pin values, which are kept parallel to pinNumbers.
  *\n
  * \n This approach also allows inputs and outputs to be mixed in the Excel sheet. So no need to define the inputs
  * first and then the outputs. The testcases are generated in the same order as the pin order.
  *\n
  * \n When a digitalRead Takes place, a check is made if the waiting test case is allowed to be executed. If so
- * the test case data is copied to pinVAL and an actionText field. At the same time a new test case
+ * the test case data is copied to the input pins and the description is sent. At the same time a new test case
  * is read into memory. We need to do it this way as the delay time before a test case becomes active is also
  * stored in the test case. The limit of testcases is 10000 although that number will probably never be reached
  * due to Flash Memory size limitations.
@@ -101,12 +101,192 @@
  * If a read operations gets result val then the displayPins operation is not called avoiding many
  * polling reads
  */
-void AutoTest::doNotDisplayReadsIf(uint8_t val) {
+void AutoTestBase::doNotDisplayReadsIf(uint8_t val) {
 
 	omitDisplayIf = val;
 }
 /**
- * @name AutoTest
+ * @name coalesceReads(bool on)
+ * @param on	true to count repeated reads
+ * A sketch that polls a pin reads the same value over and over again. With coalescing on, a read of the same pin
+ * with the same value as the read before, with nothing else happening in between, is not displayed but counted.
+ * The count is sent as "pin X read n more times over t usec" when something else happens
+ */
+void AutoTestBase::coalesceReads(bool on) {
+
+	if (!on) {
+		sendPendingReads();
+	}
+	coalesce = on;
+}
+/**
+ * @name sendPendingReads()
+ * Sends the number of repeated reads that were counted but not sent yet. The host build calls this at the end
+ */
+void AutoTestBase::sendPendingReads() {
+
+	if (repeatedReads != 0) {
+		traceEvent(AUTOTEST_EVENT_READ_REPEAT, readRunPin, repeatedReads);
+	}
+	readRunPin = 255;
+}
+/**
+ * @name testSetCompleted()
+ * @returns true if all the test cases are activated. This allows a host program to stop the sketch
+ */
+bool AutoTestBase::testSetCompleted() {
+
+	return nextTestCaseNumber == 10000;
+}
+/**
+ * @name callMillis()
+ * @returns unsigned long	time in msec
+ * rerouting of standard millis function. On the host it returns the virtual clock
+ */
+unsigned long AutoTestBase::callMillis() {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	//
+	// every look at the clock takes a bit of time otherwise busy waiting on the clock never ends
+	//
+	clockQueried 	= true;
+	clockMicros		+= AUTOTEST_CLOCK_TICK;
+	return clockMicros / 1000UL;
+#else
+	return millis();
+#endif
+}
+/**
+ * @name callMicros()
+ * @returns unsigned long	time in usec
+ * rerouting of standard micros function. On the host it returns the virtual clock
+ */
+unsigned long AutoTestBase::callMicros() {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	clockQueried 	= true;
+	clockMicros		+= AUTOTEST_CLOCK_TICK;
+	return clockMicros;
+#else
+	return micros();
+#endif
+}
+/**
+ * @name callDelay(unsigned long ms)
+ * @param ms	delay time in msec
+ * rerouting of standard delay function. On the host the virtual clock is moved forward without waiting
+ */
+void AutoTestBase::callDelay(unsigned long ms) {
+
+	flush();							// waiting is a good moment to send the trace buffer
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	clockDelayed 	= true;
+	advanceClock(ms * 1000UL);
+#else
+	if (numberOfInterrupts != 0) {
+		//
+		// the handlers run at the moment their test case is due, not when the sketch reads a pin after the delay
+		//
+		unsigned long start = millis();
+
+		while (millis() - start < ms) {
+			activateNextTestCase();
+		}
+	} else {
+		delay(ms);
+	}
+#endif
+}
+/**
+ * @name callDelayMicroseconds(unsigned int us)
+ * @param us	delay time in usec
+ * rerouting of standard delayMicroseconds function. On the host the virtual clock is moved forward without waiting
+ */
+void AutoTestBase::callDelayMicroseconds(unsigned int us) {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	clockDelayed 	= true;
+	advanceClock(us);
+#else
+	delayMicroseconds(us);
+#endif
+}
+/**
+ * @name idle()
+ * Called after every pass through loop(). If the sketch did not wait during this pass it is idle and the virtual
+ * clock is moved forward:
+ * \n - if the sketch did not look at the clock either, nothing in the sketch depends on time so the clock jumps
+ * straight to the moment the next test case is activated
+ * \n - otherwise the sketch polls its own timers and the clock moves AUTOTEST_IDLE_STEP usec (but never past the
+ * next activation)
+ * On the board this function does nothing
+ */
+void AutoTestBase::idle() {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	unsigned long nextActivation;		// first usec at which the next test case gets activated
+
+	if (!clockDelayed) {
+		nextActivation = (activateTestCase + 1) * 1000UL;
+		if (nextTestCaseNumber != 10000 && nextActivation > clockMicros &&
+			(!clockQueried || nextActivation < clockMicros + AUTOTEST_IDLE_STEP)) {
+			clockMicros = nextActivation;
+		} else {
+			clockMicros += AUTOTEST_IDLE_STEP;
+		}
+	}
+	clockQueried = false;
+	clockDelayed = false;
+	//
+	// a sketch that only waits for its interrupts never reads a pin, so the test case is activated here
+	//
+	if (numberOfInterrupts != 0) {
+		activateNextTestCase();
+	}
+#endif
+}
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+/**
+ * @name advanceClock(unsigned long us)
+ * @param us	usec to move the virtual clock
+ * With interrupt handlers attached, a test case that is due during the wait is activated at its own moment, so its
+ * handlers run in the middle of a delay() like they would on the board. Without handlers the clock just moves and
+ * the test case waits for the next read or write as before
+ */
+void AutoTestBase::advanceClock(unsigned long us) {
+
+	unsigned long end = clockMicros + us;				// usec at which the wait is over
+
+	while (numberOfInterrupts != 0 && nextTestCaseNumber != 10000 &&
+		   (activateTestCase + 1) * 1000UL > clockMicros && (activateTestCase + 1) * 1000UL <= end) {
+		clockMicros = (activateTestCase + 1) * 1000UL;
+		activateNextTestCase();
+	}
+	clockMicros = end;
+}
+#endif
+/**
+ * @name clockTime()
+ * @returns unsigned long	time in usec
+ * Time used by AutoTest itself. Unlike callMicros() this does not move the virtual clock
+ */
+unsigned long AutoTestBase::clockTime() {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	return clockMicros;
+#else
+	return micros();
+#endif
+}
+/**
+ * @name clockMillis()
+ * @returns unsigned long	time in msec
+ * Time used by AutoTest itself. Unlike callMillis() this does not move the virtual clock
+ */
+unsigned long AutoTestBase::clockMillis() {
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	return clockMicros / 1000UL;
+#else
+	return millis();
+#endif
+}
+/**
+ * @name AutoTestBase
  * @param numberOfPins			Number of pins used in the test cases
  * @param numberOfInputPins 	number of pins used in the test cases
  * @param maxFieldLength 		maximum length of pin names that exist in the test cases
@@ -115,12 +295,12 @@ void AutoTest::doNotDisplayReadsIf(uint8_t val) {
  * @param pointerTestCases 		address of testCases file in FLASH memory
  * Constructor
  */
-AutoTest::AutoTest(	uint8_t numberOfPins		,
-					uint8_t numberOfInputPins	,
-					uint8_t maxFieldLength		,
-					uint8_t maxDescriptionLength,
-					PGM_P 	pointerPinHeaders	,
-					PGM_P 	pointerTestCases	) {
+AutoTestBase::AutoTestBase(	uint8_t numberOfPins		,
+						uint8_t numberOfInputPins	,
+						uint8_t maxFieldLength		,
+						uint8_t maxDescriptionLength,
+						PGM_P 	pointerPinHeaders	,
+						PGM_P 	pointerTestCases	) {
 	//
 	// save all the parameters in the class object
 	//
@@ -130,23 +310,130 @@ AutoTest::AutoTest(	uint8_t numberOfPins		,
 	Max_Description_Length	= maxDescriptionLength;
 	pinHeaders 				= pointerPinHeaders;
 	testCases				= pointerTestCases;
-	//
-	// allocate arrays with the correct sizes and quantities
-	//
-	nextInputValues 		= (uint16_t *) 	malloc(Number_Of_Input_Pins * sizeof(uint16_t));
-	pinMap					= (uint8_t *) 	malloc((numberOfPins * sizeof(uint8_t)));
-	pinVal					= (uint16_t *) 	malloc(numberOfPins * sizeof(uint16_t));
-	pinDescriptions 		= (char *) 	  	malloc((numberOfPins * maxFieldLength));
+	packedTestCases			= NULL;				// test cases are in CSV form
+	testCaseStream			= NULL;				// and in Flash
+	streamBuffer			= NULL;
+	streamRecordLength		= 0;
+	streamWaiting			= false;
+	//
+	// the arrays are members of AutoTest<> which sets the pointers once this constructor is done
+	//
+	nextInputValues			= NULL;
+	pinNumbers				= NULL;
+	inputPinBits			= NULL;
+	inputList				= NULL;
+	numberOfInputs			= 0;
+	digitalBits				= NULL;
+	sentDigitalBits			= NULL;
+	analogPinBits			= NULL;
+	analogValues			= NULL;
+	sentAnalogValues		= NULL;
+	numberOfAnalog			= 0;
+	maxAnalog				= 0;
+	nextExpectedValues		= NULL;
+	expectedValues			= NULL;
+	maxExpected				= 0;
+	pinNames				= NULL;
+#ifdef AUTOTEST_COMPACT_PIN_LOOKUP
+	rankToIndex				= NULL;
+#endif
 	//
 	// other initializations
 	//
 	omitDisplayIf = 99;					// display both reads and writes
+	coalesce			 = false;
+	readRunPin			 = 255;
+	repeatedReads		 = 0L;
+	outputMode			 = AUTOTEST_OUTPUT_CSV;
+	keyframeInterval	 = AUTOTEST_KEYFRAME_INTERVAL;
+	recordsToKeyframe	 = 0;				// start with a keyframe
+	lastRecordTime		 = 0L;
+	output				 = &Serial;			// AutoTest<> switches to traceBuffer if there is one
+	latency				 = NULL;			// and sets latency if it is measured
+	nextGenerators		 = NULL;			// and the generators if they are used
+	generators			 = NULL;
+	interrupts			 = NULL;			// and the interrupt handlers
+	numberOfInterrupts	 = 0;
+	maxInterrupts		 = 0;
+#ifdef AUTOTEST_HOST
+	numberOfStateBlocks	 = 0;				// AutoTest<> and AutoTestHost register their memory
+#endif
+	activationTime		 = 0L;
+	nextNumberOfExpected = 0;
+	numberOfExpected	 = 0;
+	checkPending		 = false;
+	resultSent			 = false;
+	testsPassed			 = 0;
+	testsFailed			 = 0;
+	pendingDropped		 = 0;
+	droppedTotal		 = 0L;
+	captureArmed		 = false;			// everything is sent until captureOnTrigger()
+	captureBefore		 = 0;
+	captureAfter		 = 0;
+	captureLeft			 = 0;
+	triggerPinIndex		 = 255;
+	triggerValue		 = 0;
+	triggerTestCase		 = -1;
+	triggerCondition	 = NULL;
+	triggerLevel		 = false;
+	activeTestCaseNumber = -1;			// no test case active yet
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	clockMicros		= 0L;				// the virtual clock starts at 0 like the board does
+	clockQueried	= false;
+	clockDelayed	= false;
+#endif
+}
+/**
+ * @name AutoTestBase
+ * @param numberOfPins			Number of pins used in the test cases
+ * @param numberOfInputPins 	number of pins used in the test cases
+ * @param maxFieldLength 		maximum length of pin names that exist in the test cases
+ * @param maxDescriptionLength 	Maximum length of test case descriptions in test cases
+ * @param pointerPinHeaders  	address of pinHeaders file in FLASH memory
+ * @param pointerTestCases 		address of the packed test case records in FLASH memory
+ * @param pointerDescriptions 	address of the test case descriptions in FLASH memory
+ * @param numberOfTestCases		number of records in pointerTestCases
+ * Constructor for test cases in packed binary form (see getPackedTestCase())
+ */
+AutoTestBase::AutoTestBase(	uint8_t 		numberOfPins		,
+						uint8_t 		numberOfInputPins	,
+						uint8_t 		maxFieldLength		,
+						uint8_t 		maxDescriptionLength,
+						PGM_P 			pointerPinHeaders	,
+						const uint16_t	*pointerTestCases	,
+						PGM_P 			pointerDescriptions	,
+						unsigned int	numberOfTestCases	)
+	: AutoTestBase(numberOfPins, numberOfInputPins, maxFieldLength, maxDescriptionLength, pointerPinHeaders, (PGM_P)NULL) {
+
+	packedTestCases			= pointerTestCases;
+	testCaseDescriptions	= pointerDescriptions;
+	numberOfPackedTestCases	= numberOfTestCases;
+}
+/**
+ * @name AutoTestBase
+ * @param numberOfPins			Number of pins used in the test cases
+ * @param numberOfInputPins 	number of pins used in the test cases
+ * @param maxFieldLength 		maximum length of pin names that exist in the test cases
+ * @param maxDescriptionLength 	Maximum length of test case descriptions in test cases
+ * @param pointerPinHeaders  	address of pinHeaders file in FLASH memory
+ * @param stream				where the test case records come from (see getStreamTestCase())
+ * Constructor for test cases sent over Serial by a feeder instead of stored in Flash
+ */
+AutoTestBase::AutoTestBase(	uint8_t 		numberOfPins		,
+						uint8_t 		numberOfInputPins	,
+						uint8_t 		maxFieldLength		,
+						uint8_t 		maxDescriptionLength,
+						PGM_P 			pointerPinHeaders	,
+						Stream			*stream				)
+	: AutoTestBase(numberOfPins, numberOfInputPins, maxFieldLength, maxDescriptionLength, pointerPinHeaders, (PGM_P)NULL) {
+
+	testCaseStream			= stream;
 }
 /**
  * @name begin()
  * Normal initialization of the AutoTest library. This function does not call an extended display pins function
  */
-void AutoTest::begin() {
+void AutoTestBase::begin() {
 	//
 	// set the extended displayPins function to NULL
 	//
@@ -163,7 +450,7 @@ void AutoTest::begin() {
  * Normal initialization of the AutoTest library but now with a function pointer to extend display pins/ using this
  * method allows the user to add additional fields to the Serial Output
  */
-void AutoTest::begin(void (*extendDisplayPins)()) {
+void AutoTestBase::begin(void (*extendDisplayPins)()) {
 	//
 	// save the function pointer
 	//
@@ -179,30 +466,34 @@ void AutoTest::begin(void (*extendDisplayPins)()) {
  * This is the initialization method for AutoTest. All the pin descriptions and definitions are put in a
  * couple of arrays and stored for later use. also the first test case is loaded
  */
-void AutoTest::_begin(){
+void AutoTestBase::_begin(){
 	PGM_P 			recordPtr;				// points to a record in Flash memory
 	unsigned int 	recordLength;			// length of the current record in Flash memory
-	char			pin[3];					// pin id in string form
-	char			*field = (char *)malloc(Max_Field_Length); // result field for field pin description when obtained from Flash memory
+	char			pin[4];					// pin id in string form
+	PGM_P			namePtr;				// the name of the pin in Flash
 	uint8_t			iPin;					// pin number in integer form
 	uint8_t			numberOfPins;			// keeps track of pins while loading arrays
 
 	//
-	// initialize the pinMap & pinVal
+	// initialize the pin table & the values. All pins are INPUT and 0 until the sketch calls pinMode()
 	//
-	uint8_t j = 0;
+	memset(inputPinBits, 0xFF, AUTOTEST_PIN_BITS(Number_Of_Pins));
+	memset(digitalBits, 0, AUTOTEST_PIN_BITS(Number_Of_Pins));
+	memset(sentDigitalBits, 0, AUTOTEST_PIN_BITS(Number_Of_Pins));
+	memset(analogPinBits, 0, AUTOTEST_PIN_BITS(Number_Of_Pins));
+	numberOfAnalog = 0;
 	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
-		//
-		// calculate array offset
-		//
-		j = i * 2;
-		pinMap[j] 	= 255;			// default value for pin not used
-		pinMap[j+1]	= INPUT;		// default all pins are set to INPUT
-		pinVal[i] 	= 0;			// default value = 0
+		pinNumbers[i] 	= 255;			// default value for pin not used
+		if (latency != NULL) {
+			memset(&latency[i], 0, sizeof(AutoTestLatency));
+		}
+		if (generators != NULL) {
+			generators[i].type = AUTOTEST_GENERATOR_NONE;
+		}
 	}
 
 	//
-	// copy the pinHeaders list from flash to RAM
+	// copy the pin numbers from flash to RAM. The names stay in Flash
 	//
 	recordPtr = pinHeaders;				// points to the first character in the Field array
 	//
@@ -212,22 +503,20 @@ void AutoTest::_begin(){
 	//
 	// process all defined pins
 	//
-	numberOfPins 		= 0;			// point to first index in pin array (pinMap)
+	numberOfPins 		= 0;			// point to first index in pin array (pinNumbers)
 	while (recordLength != 0) {
 		//
 		// get the pin, convert it to an int and put it in the array
 		//
 		recordPtr 				= getToken(recordPtr, pin, ',');// find the pin number and copy it to RAM
 		iPin 					= atoi(pin);					// convert to int
-		pinMap[numberOfPins * 2]= iPin;							// and save it in the array. This keeps the order of the Excel file
-		//
-		// getToken returns the first byte address after the token so we can continue to the next fiedl
-		//
-		recordPtr 				= getToken(recordPtr, field, '\n'); // get pin name
+		pinNumbers[numberOfPins]= iPin;							// and save it in the array. This keeps the order of the Excel file
 		//
-		// and copy it in the pinDescriptions array
+		// getToken returns the first byte address after the token so we can continue to the next field, the name
 		//
-		strcpy(&pinDescriptions[(numberOfPins * Max_Field_Length)], field);
+		pinNames[numberOfPins]	= recordPtr - pinHeaders;		// where the name starts
+		namePtr					= strchr_P(recordPtr, '\n');	// and ends
+		recordPtr				= namePtr + 1;
 		numberOfPins++;								// increment number of pins used as we need this later for the testcases
 		//
 		// get the new record length
@@ -237,10 +526,26 @@ void AutoTest::_begin(){
 
 	//
 	// We now have an array with all the input / output pins used in the same order as the Excel sheet
+	// so the lookup from pin number to index can be made
 	//
+	buildPinIndex();
+	buildInputList();
 	nextTestCaseNumber 	= -1;			// start with the first testCase(number is incremented first so it becomes 0)
 	activateTestCase 	= 0L;			// set wait time to known value
 	testCasePtr 		= testCases;	// point to first testcase
+	if (testCaseStream != NULL) {
+		//
+		// both record buffers are free, so the feeder can send two records
+		//
+		streamFill			= 0;
+		streamWrite			= 0;
+		streamRead			= 0;
+		streamReady[0]		= false;
+		streamReady[1]		= false;
+		for (uint8_t i = 0; i < 2; i++) {
+			requestStreamRecord();
+		}
+	}
 	getTestCase();						// get the first testcase
 }
 
@@ -248,15 +553,16 @@ void AutoTest::_begin(){
  * @name callPinMode(uint8_t pin, uint8_t mode)
  * @param pin 	pin number of Arduino board
  * @param mode	INPUT, INPUT_PULLUP or OUTPUT
- * Rerouting of standard pinMode function. The pin modes are stored into array pinMap(column 1). The first column
- * is the mapping to the real pin. If the pin is an INPUT_PULLUP then the value is set to "1"
+ * Rerouting of standard pinMode function. Only if the pin is an input or not is stored, in inputPinBits. If the pin
+ * is an INPUT_PULLUP then the value is set to "1"
  * Doing it this way avoids creating an entry for every pin on the Arduino board
  */
-void AutoTest::callPinMode(uint8_t pin, uint8_t mode) {		// replacement function for pinMode()
+void AutoTestBase::callPinMode(uint8_t pin, uint8_t mode) {		// replacement function for pinMode()
 
-	unsigned int pinIndex;			// index to pinMap for this pin. It maps the actual pin to the index in pinMap
+	unsigned int pinIndex;			// index of this pin. It maps the actual pin to the index in the pin table
+	bool		input = mode == INPUT || mode == INPUT_PULLUP;
 	//
-	// First we have to find the index in the indexed pinMap
+	// First we have to find the index in the pin table
 	//
 	pinIndex = getPinIndex(pin);
 	//
@@ -264,27 +570,27 @@ void AutoTest::callPinMode(uint8_t pin, uint8_t mode) {		// replacement function
 	//
 	if (pinIndex != Number_Of_Pins) {
 		//
-		// we found the index in the pinMap array so set mode
+		// we found the index in the pin table so set mode. The input list only changes if the pin becomes an input
+		// or stops being one
 		//
-		pinMap[((pinIndex * 2)+1)] = mode;
+		if (input != isInputPin(pinIndex)) {
+			inputPinBits[pinIndex >> 3] ^= 1 << (pinIndex & 7);
+			buildInputList();
+		}
 		//
 		// set pin value. If mode is PULLUP then the input value is default 1
 		//
 		if (mode == INPUT || mode == OUTPUT) {
-			pinVal[pinIndex] = LOW;					// default value is 0
+			setPinValue(pinIndex, LOW);				// default value is 0
 		} else {
-			pinVal[pinIndex] = HIGH;				// with pullup it is 1
+			setPinValue(pinIndex, HIGH);			// with pullup it is 1
 		}
+		traceEvent(AUTOTEST_EVENT_PIN_MODE, pinIndex, mode);
 	} else {
 		//
 		// this pin is not defined in the test set so let the user know
 		//
-		Serial.println("");
-		Serial.print("pinMode (");
-		Serial.print(pin);
-		Serial.print(",");
-		Serial.print(mode);
-		Serial.println(") invalid pin");
+		traceEvent(AUTOTEST_EVENT_INVALID_PIN_MODE, pin, mode);
 	}
 }
 
@@ -295,8 +601,8 @@ void AutoTest::callPinMode(uint8_t pin, uint8_t mode) {		// replacement function
  * rerouting of standard digitalRead function. This function reads the pin from the digital Array. However if
  * a testcase becomes active, the value from the test set is written to it before the read takes place
  */
-uint8_t AutoTest::callDigitalRead(uint8_t pin) {		// replacement function for digitalRead()
-	uint8_t 	pinIndex;							// mapping pin to pinMap
+uint8_t AutoTestBase::callDigitalRead(uint8_t pin) {		// replacement function for digitalRead()
+	uint8_t 	pinIndex;							// mapping pin to the pin table
 	uint8_t		val;								// value to return
 
 	activateNextTestCase();								// if there is a testcase, it gets Activated
@@ -307,9 +613,12 @@ uint8_t AutoTest::callDigitalRead(uint8_t pin) {		// replacement function for di
 	//
 	if (pinIndex != Number_Of_Pins) {
 		//
-		// get value
+		// get value. A generator gives the value it has at this moment
 		//
-		val = pinVal[pinIndex];
+		if (generators != NULL && generators[pinIndex].type != AUTOTEST_GENERATOR_NONE) {
+			setPinValue(pinIndex, generatorValue(pinIndex));
+		}
+		val = getPinValue(pinIndex);
 		//
 		// check if we actually have to display this info
 		//
@@ -317,10 +626,7 @@ uint8_t AutoTest::callDigitalRead(uint8_t pin) {		// replacement function for di
 			//
 			// now inform the user of this read
 			//
-			strcpy(actionText, "pin ");
-			strcat(actionText, (char *)&pinDescriptions[(pinIndex * Max_Field_Length)]);
-			strcat(actionText, " read");
-			displayPins();
+			traceRead(pinIndex, val);
 		}
 		//
 		// and return the test case value for this pin
@@ -330,10 +636,7 @@ uint8_t AutoTest::callDigitalRead(uint8_t pin) {		// replacement function for di
 		//
 		// this pin is not defined in the test set so let the user know
 		//
-		Serial.println("");
-		Serial.print("digitalRead(");
-		Serial.print(pin);
-		Serial.println(") invalid pin");
+		traceEvent(AUTOTEST_EVENT_INVALID_READ, pin, 0);
 		return 0;
 	}
 }
@@ -344,8 +647,8 @@ uint8_t AutoTest::callDigitalRead(uint8_t pin) {		// replacement function for di
  * rerouting of standard digitalRead function. This function reads the pin from the digital Array. However if
  * a testcase becomes active, the value from the test set is written to it before the read takes place
  */
-int AutoTest::callAnalogRead(uint8_t pin) {			// replacement function for digitalRead()
-	uint8_t 	 pinIndex;							// mapping pin to pinMap
+int AutoTestBase::callAnalogRead(uint8_t pin) {			// replacement function for digitalRead()
+	uint8_t 	 pinIndex;							// mapping pin to the pin table
 	int  		 val;								// value to return (0 - 1023)
 
 	activateNextTestCase();							// if there is a testcase, it gets Activated
@@ -371,9 +674,12 @@ int AutoTest::callAnalogRead(uint8_t pin) {			// replacement function for digita
 	//
 	if (pinIndex != Number_Of_Pins) {
 		//
-		// get value
+		// get value. A generator gives the value it has at this moment
 		//
-		val = pinVal[pinIndex];
+		if (generators != NULL && generators[pinIndex].type != AUTOTEST_GENERATOR_NONE) {
+			setPinValue(pinIndex, generatorValue(pinIndex));
+		}
+		val = getPinValue(pinIndex);
 		//
 		// check if we actually have to display this info
 		//
@@ -381,10 +687,7 @@ int AutoTest::callAnalogRead(uint8_t pin) {			// replacement function for digita
 			//
 			// now inform the user of this read
 			//
-			strcpy(actionText, "pin ");
-			strcat(actionText, (char *)&pinDescriptions[(pinIndex * Max_Field_Length)]);
-			strcat(actionText, " read");
-			displayPins();
+			traceRead(pinIndex, val);
 		}
 		//
 		// and return the test case value for this pin
@@ -394,10 +697,7 @@ int AutoTest::callAnalogRead(uint8_t pin) {			// replacement function for digita
 		//
 		// this pin is not defined in the test set so let the user know
 		//
-		Serial.println("");
-		Serial.print("analogRead(");
-		Serial.print(pin);
-		Serial.println(") invalid pin");
+		traceEvent(AUTOTEST_EVENT_INVALID_ANALOG_READ, pin, 0);
 		return 0;
 	}
 }
@@ -408,14 +708,13 @@ int AutoTest::callAnalogRead(uint8_t pin) {			// replacement function for digita
  * @param val	value to write to Pin
  * rerouting of standard digitalWrite function. this function sets the pin value in the pinArray (containing all digital pins)
  */
-void AutoTest::callDigitalWrite(uint8_t pin, uint8_t val) {		// replacement function for digitalWrite()
+void AutoTestBase::callDigitalWrite(uint8_t pin, uint8_t val) {		// replacement function for digitalWrite()
 
-	uint8_t pinIndex;					// maps the pin to the pinMap array index
-	char 	level[5];					// string for HIGH and LOW text
+	uint8_t pinIndex;					// maps the pin to the pin table index
 	//
 	// set the correct value
 	//
-	pinIndex		= getPinIndex(pin);	// get pinMap index
+	pinIndex		= getPinIndex(pin);	// get pin index
 	//
 	// check if it is a valid pin
 	//
@@ -427,41 +726,25 @@ void AutoTest::callDigitalWrite(uint8_t pin, uint8_t val) {		// replacement func
 			//
 			// The user is trying to send junk to pin
 			//
-			Serial.println("");
-			Serial.print("digitalWrite(");
-			Serial.print(pin);
-			Serial.print(",");
-			Serial.print(val);
-			Serial.println(") error. Value sent is not HIGH or LOW");
+			traceEvent(AUTOTEST_EVENT_INVALID_VALUE, pin, val);
 		} else {
 			//
 			// evrything is valid so perform write
 			//
-			pinVal[pinIndex] = val;
+			bool changed		= setPinValue(pinIndex, val);
 			//
 			// now inform the user of this write
 			//
-			if (val == 0) {
-				strcpy(level, "LOW");
-			} else {
-				strcpy(level, "HIGH");
+			traceEvent(AUTOTEST_EVENT_WRITE, pinIndex, val);
+			if (changed) {
+				pinChanged(pinIndex);
 			}
-			strcpy(actionText, "pin ");
-			strcat(actionText, (char *)&pinDescriptions[(pinIndex * Max_Field_Length)]);
-			strcat(actionText, " set to ");
-			strcat(actionText, level);
-			displayPins();
 		}
 	} else {
 		//
 		// this pin is not defined in the test set so let the user know
 		//
-		Serial.println("");
-		Serial.print("digitalWrite(");
-		Serial.print(pin);
-		Serial.print(",");
-		Serial.print(val);
-		Serial.println(") invalid pin");
+		traceEvent(AUTOTEST_EVENT_INVALID_WRITE, pin, val);
 	}
 }
 /**
@@ -471,14 +754,13 @@ void AutoTest::callDigitalWrite(uint8_t pin, uint8_t val) {		// replacement func
  * rerouting of standard digitalWrite function. this function sets the pin value in the pinArray (containing all digital pins)
  * Keep in mind we do not check if this is a valid PWM pin
  */
-void AutoTest::callAnalogWrite(uint8_t pin, uint8_t val) {		// replacement function for digitalWrite()
+void AutoTestBase::callAnalogWrite(uint8_t pin, uint8_t val) {		// replacement function for digitalWrite()
 
-	uint8_t pinIndex;					// maps the pin to the pinMap array index
-	char valString[4];					// string value of pwm value
+	uint8_t pinIndex;					// maps the pin to the pin table index
 	//
 	// set the correct value
 	//
-	pinIndex		= getPinIndex(pin);	// get pinMap index
+	pinIndex		= getPinIndex(pin);	// get pin index
 	//
 	// check if it is a valid pin
 	//
@@ -486,156 +768,1369 @@ void AutoTest::callAnalogWrite(uint8_t pin, uint8_t val) {		// replacement funct
 		//
 		// No need to check the value as it can be any value from 0-255
 		//
-		pinVal[pinIndex] = val;
+		bool changed		= setPinValue(pinIndex, val);
 		//
 		// now inform the user of this write
 		//
-		strcpy(actionText, "pin ");
-		strcat(actionText, (char *)&pinDescriptions[(pinIndex * Max_Field_Length)]);
-		strcat(actionText, " set to ");
-		itoa(val, valString, 10);
-		strcat(actionText, valString);
-		displayPins();
+		traceEvent(AUTOTEST_EVENT_ANALOG_WRITE, pinIndex, val);
+		if (changed) {
+			pinChanged(pinIndex);
+		}
 	} else {
 		//
 		// this pin is not defined in the test set so let the user know
 		//
-		Serial.println("");
-		Serial.print("digitalWrite(");
-		Serial.print(pin);
-		Serial.print(",");
-		Serial.print(val);
-		Serial.println(") invalid pin");
+		traceEvent(AUTOTEST_EVENT_INVALID_ANALOG_WRITE, pin, val);
 	}
 }
+/**
+ * @name callAttachInterrupt(uint8_t interrupt, void (*handler)(), int mode)
+ * @param interrupt	number of the interrupt (digitalPinToInterrupt(pin))
+ * @param handler	function to call
+ * @param mode		LOW, CHANGE, RISING or FALLING
+ * Rerouting of standard attachInterrupt function. The handler is kept with the pin of the test set that has this
+ * interrupt and called when a test case gives the pin the edge of mode (see checkInterrupts()). The table is kept in
+ * the order of the pin table so the handlers of one activation always run in the same order
+ */
+void AutoTestBase::callAttachInterrupt(uint8_t interrupt, void (*handler)(), int mode) {
 
+	uint8_t pinIndex = Number_Of_Pins;					// pin with this interrupt
+	uint8_t i;
+
+	for (i = 0; i < Number_Of_Pins; i++) {
+		if (pinNumbers[i] < NUM_DIGITAL_PINS && digitalPinToInterrupt(pinNumbers[i]) == interrupt) {
+			pinIndex = i;
+			break;
+		}
+	}
+	callDetachInterrupt(interrupt);
+	if (pinIndex == Number_Of_Pins || numberOfInterrupts == maxInterrupts) {
+		//
+		// this interrupt is not on a pin of the test set or AUTOTEST_INTERRUPTS is too small, so let the user know
+		//
+		traceEvent(AUTOTEST_EVENT_INVALID_INTERRUPT, interrupt, mode);
+		return;
+	}
+	for (i = numberOfInterrupts; i > 0 && interrupts[i - 1].pinIndex > pinIndex; i--) {
+		interrupts[i] = interrupts[i - 1];
+	}
+	interrupts[i].handler	= handler;
+	interrupts[i].pinIndex	= pinIndex;
+	interrupts[i].mode		= mode;
+	interrupts[i].level		= getPinValue(pinIndex) != 0;
+	numberOfInterrupts++;
+}
 /**
- * @name displayPins()
- * @param pin 	pin number of Arduino board
- * @param val	value to write to Pin
- * rerouting of standard digitalWrite function. this function sets the pin value in the pinArray (containing all digital pins)
- *
+ * @name callDetachInterrupt(uint8_t interrupt)
+ * @param interrupt	number of the interrupt (digitalPinToInterrupt(pin))
+ * Rerouting of standard detachInterrupt function
  */
-void AutoTest::displayPins() {
-	//
-	// print the action text
-	//
-	Serial.println("");
-	Serial.print(actionText);
-	Serial.print(CSV_SEPARATOR);
-	//
-	// check each pin if it is defined in the program. Defined means it was programmed through pinMode()
-	//
+void AutoTestBase::callDetachInterrupt(uint8_t interrupt) {
+
+	for (uint8_t i = 0; i < numberOfInterrupts; i++) {
+		if (digitalPinToInterrupt(pinNumbers[interrupts[i].pinIndex]) == interrupt) {
+			numberOfInterrupts--;
+			memmove(&interrupts[i], &interrupts[i + 1], (numberOfInterrupts - i) * sizeof(AutoTestInterrupt));
+			return;
+		}
+	}
+}
+#ifdef AUTOTEST_HAS_PORTS
+/**
+ * @name callPortRead(uint8_t port, uint8_t reg)
+ * @param port	port of the board (PB, PC etc)
+ * @param reg	AUTOTEST_REGISTER_PORT, _PIN or _DDR
+ * @returns uint8_t	the register made from the pins of the test set on this port. Other bits are 0
+ * Replaces reading PORTx, PINx and DDRx (AUTOTEST_PORTS). Reading PINx is like a digitalRead() of all the pins of
+ * the port at once, so it can activate the next test case and is sent as one AUTOTEST_EVENT_PORT_READ
+ */
+uint8_t AutoTestBase::callPortRead(uint8_t port, uint8_t reg) {
+
+	uint8_t	value = 0;						// the register
+	uint8_t	pins = 0;						// bits that are pins of the test set
+
+	if (reg == AUTOTEST_REGISTER_PIN) {
+		activateNextTestCase();
+	}
 	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
-		Serial.print(pinVal[i]);		// print Value
-		Serial.print(CSV_SEPARATOR);				// print a separator
+		uint8_t bit = portBit(i, port);
+
+		if (bit == 0) {
+			continue;
+		}
+		pins |= bit;
+		if (reg == AUTOTEST_REGISTER_DDR) {
+			value |= isInputPin(i) ? 0 : bit;
+		} else if (reg == AUTOTEST_REGISTER_PIN || !isInputPin(i)) {
+			if (generators != NULL && generators[i].type != AUTOTEST_GENERATOR_NONE) {
+				setPinValue(i, generatorValue(i));
+			}
+			value |= getPinValue(i) != 0 ? bit : 0;
+		}
 	}
-	//
-	// check if the user wants more output
-	//
-	if (callExtendDisplayPins != NULL) {
-		callExtendDisplayPins();					// allow the user to extend the info to serial
+	if (reg == AUTOTEST_REGISTER_PIN && pins != 0) {
+		traceEvent(AUTOTEST_EVENT_PORT_READ, port, value);
 	}
+	return value;
 }
 /**
- * @name getTestCase()
- * @returns testCaseAvailable 0 = no more test cases 1 = still testcases
- * Reads the testcase if there is one and returns 1. Otherwise returns 0
- *
+ * @name callPortWrite(uint8_t port, uint8_t reg, uint8_t value)
+ * @param port	port of the board (PB, PC etc)
+ * @param reg	AUTOTEST_REGISTER_PORT, _PIN or _DDR
+ * @param value	value written to the register
+ * Replaces writing PORTx, PINx and DDRx (AUTOTEST_PORTS). A write to PORTx sets all the output pins of the port
+ * together and is sent as one AUTOTEST_EVENT_PORT_WRITE. In binary mode the pins that changed go before it as
+ * AUTOTEST_EVENT_PORT_PIN so decodeTrace knows their values. Writing PINx toggles the outputs of the bits that are
+ * set, like on the board. Writing DDRx is a pinMode() of each pin whose direction changes. A port without pins of
+ * the test set is ignored
  */
-uint8_t AutoTest::getTestCase(){
+void AutoTestBase::callPortWrite(uint8_t port, uint8_t reg, uint8_t value) {
 
-	uint8_t  returnCode;				// result of this operation
-	char	 pinValue[5];				// value of pin as a string (could be 0-1023
-	char	 delayTime[10];				// delay time as string
-	uint16_t recordLength;				// returns the length of a record in testcases
+	uint8_t	changed = 0;					// bits of the pins that got another value
+	uint8_t	pins = 0;						// bits that are pins of the test set
+
+	if (reg == AUTOTEST_REGISTER_PIN) {
+		value ^= callPortRead(port, AUTOTEST_REGISTER_PORT);
+	}
+	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+		uint8_t bit = portBit(i, port);
 
+		if (bit == 0) {
+			continue;
+		}
+		pins |= bit;
+		if (reg == AUTOTEST_REGISTER_DDR) {
+			if (((value & bit) == 0) != isInputPin(i)) {
+				callPinMode(pinNumbers[i], value & bit ? OUTPUT : INPUT);
+			}
+		} else if (!isInputPin(i) && setPinValue(i, (value & bit) != 0)) {
+			changed |= bit;
+			traceEvent(AUTOTEST_EVENT_PORT_PIN, i, (value & bit) != 0);
+		}
+	}
+	if (reg == AUTOTEST_REGISTER_DDR) {
+		return;
+	}
+	if (pins == 0) {
+		return;								// no pin of the test set is on this port
+	}
+	traceEvent(AUTOTEST_EVENT_PORT_WRITE, port, value & pins);
 	//
-	// check if there is any testcase left
+	// the pins that changed can be a response to the test case
 	//
-	if (nextTestCaseNumber >= 10000) {
+	for (uint8_t i = 0; i < Number_Of_Pins && changed != 0; i++) {
+		if (portBit(i, port) & changed) {
+			pinChanged(i);
+		}
+	}
+}
+/**
+ * @name portBit(uint8_t pinIndex, uint8_t port)
+ * @param pinIndex	pin index
+ * @param port		port of the board (PB, PC etc)
+ * @returns uint8_t	mask of the pin in the registers of port. 0 if the pin is on another port
+ */
+uint8_t AutoTestBase::portBit(uint8_t pinIndex, uint8_t port) {
+
+	uint8_t pin = pinNumbers[pinIndex];		// pin number of the board
+
+	if (pin >= NUM_DIGITAL_PINS || digitalPinToPort(pin) != port) {
+		return 0;
+	}
+	return digitalPinToBitMask(pin);
+}
+#endif
+
+/**
+ * @name traceEvent(uint8_t type, uint8_t pin, unsigned long value)
+ * @param type	AUTOTEST_EVENT_...
+ * @param pin	pin index or the pin number for the INVALID events
+ * @param value	value of the pin, mode for AUTOTEST_EVENT_PIN_MODE or the test case number for AUTOTEST_EVENT_ACTIVATE
+ * Every read, write, pinMode and test case activation ends up here. Without a trace buffer the event is written to
+ * Serial straight away. With a trace buffer it becomes one record in the buffer. If records were dropped because the
+ * buffer was full, an AUTOTEST_EVENT_DROPPED record with their number comes first. While captureOnTrigger() waits
+ * for its trigger the event goes to the history instead
+ */
+void AutoTestBase::traceEvent(uint8_t type, uint8_t pin, unsigned long value) {
+
+	if (type == AUTOTEST_EVENT_READ_REPEAT) {
 		//
-		// limit reached
+		// the count gets the time of the last read it counted
 		//
-		nextTestCaseNumber = 10000;
-		returnCode = 1;
+		eventTime		= lastReadTime;
+		repeatedReads	= 0;
 	} else {
-		nextTestCaseNumber++;
-	}
-	//
-	// anything to process
-	//
-	if (nextTestCaseNumber < 10000) {
 		//
-		// check if we have a test case
+		// anything else ends a run of repeated reads
 		//
-		recordLength = getRecordLength(testCasePtr);
-		if (recordLength != 0) {
-			//
-			// we have a testcase So let's get it
-			//
-			// Get description
-			//
-			testCasePtr = getToken(testCasePtr, nextTestCaseDescription, ',');
+		if (readRunPin != 255) {
+			sendPendingReads();
+		}
+		eventTime = clockTime();
+	}
+	if (captureArmed) {
+		if (captureLeft == 0) {
+			captureEvent(type, pin, value);
+			return;
+		}
+		captureLeft--;							// one more event of the window
+	}
+	if (output == &Serial) {
+		writeEvent(type, pin, value);
+		return;
+	}
+	if (pendingDropped != 0) {
+		writeEvent(AUTOTEST_EVENT_DROPPED, 0, pendingDropped);
+		if (!traceBuffer.commit()) {
 			//
-			// get the test case values
+			// still no room, so this one is lost as well
 			//
-			for(uint8_t i = 0; i < Number_Of_Input_Pins; i++) {
-				//
-				// copy the values from the FLASH memory
-				//
-				testCasePtr = getToken(testCasePtr, pinValue, ',');
-				//
-				// convert the sting to an int and put in the nextInputValues array
-				//
-				nextInputValues[i] = atoi(pinValue);
+			if (pendingDropped != 0xFFFF) {
+				pendingDropped++;
 			}
-			//
-			// get the delay time of this test case
-			//
-			testCasePtr 		= getToken(testCasePtr, delayTime, '\n');
-			activationDelay 	= atoi(delayTime);
-			activateTestCase 	= millis() + activationDelay;
-			//
-			// set the return code
-			//
-			returnCode = 1;
-
-		} else {
-			//
-			// no more testcases
-			//
-			nextTestCaseNumber = 10000;
-			returnCode = 0;
+			droppedTotal++;
+			return;
 		}
-	} else {
-		//
-		// no more test cases
-		//
-		returnCode = 0;
+		pendingDropped = 0;
 	}
-	return returnCode;
+	writeEvent(type, pin, value);
+	commitRecord();
 }
+/**
+ * @name captureEvent(uint8_t type, uint8_t pin, unsigned long value)
+ * @param type	AUTOTEST_EVENT_...
+ * @param pin	pin index or the pin number for the INVALID events
+ * @param value	value of the event
+ * Writes the event to the history instead of to Serial. In delta mode every record of the history is a keyframe,
+ * as the record before it may be dropped. When the trigger fires the history is sent, followed by an
+ * AUTOTEST_EVENT_TRIGGER record and the captureAfter events after it
+ */
+void AutoTestBase::captureEvent(uint8_t type, uint8_t pin, unsigned long value) {
+	Print			*port = output;						// Serial or the trace buffer
+	unsigned long	skipped;							// events that did not make it into the history
 
+	output				= &captureBuffer;
+	recordsToKeyframe	= 0;
+	writeEvent(type, pin, value);
+	captureBuffer.commit(captureBefore);
+	output				= port;
+	if (!checkTrigger()) {
+		return;
+	}
+	skipped = captureBuffer.dropped();
+	while (captureBuffer.sendRecord(*output)) {
+		if (output != &Serial) {
+			commitRecord();
+		}
+	}
+	captureLeft = captureAfter + 1;						// the trigger record and the window after it
+	traceEvent(AUTOTEST_EVENT_TRIGGER, 0, skipped);
+}
 /**
- * @name getRecordlength ()
- * @param ptr points to a memory locationin flash Memeory
- * @returns int length of the record
- * This function returns the number of bytes to the next newline character from ptr location
+ * @name checkTrigger()
+ * @returns bool	true if the trigger condition is true now and was not at the event before
+ * The condition is true if the pin of triggerOnPin() has its value, the test case of triggerOnTestCase() is the
+ * active one or the function of triggerOn() returns true. A condition that stays true fires only once
  */
-int AutoTest::getRecordLength(PGM_P ptr) {
-	//
-	// find the newline character in Flash
-	//
-	PGM_P temp = strchr_P (ptr, '\n');
-	//
-	// return the difference
-	//
-	return temp - ptr;
+bool AutoTestBase::checkTrigger() {
+	bool level = (triggerPinIndex < Number_Of_Pins && getPinValue(triggerPinIndex) == triggerValue) ||
+				 (triggerTestCase >= 0 && activeTestCaseNumber == triggerTestCase) ||
+				 (triggerCondition != NULL && triggerCondition());
+	bool fired = level && !triggerLevel;
+
+	triggerLevel = level;
+	return fired;
 }
+/**
+ * @name captureOnTrigger(uint16_t before, uint16_t after)
+ * @param before	number of events before the trigger to send, as far as they fit in AUTOTEST_CAPTURE_BUFFER
+ * @param after		number of events after the trigger to send
+ * Like a logic analyzer: from now on only the events around a trigger (see triggerOnPin(), triggerOnTestCase() and
+ * triggerOn()) are sent. The events before it are kept in RAM, so nothing is written to Serial until the trigger
+ * fires. After the window the capture waits for the next trigger. 0 for both sends every event again. Without
+ * AUTOTEST_CAPTURE_BUFFER every event is sent
+ */
+void AutoTestBase::captureOnTrigger(uint16_t before, uint16_t after) {
 
+	if (captureBuffer.capacity() == 0) {
+		return;
+	}
+	captureArmed	= before != 0 || after != 0;
+	captureBefore	= before;
+	captureAfter	= after;
+	captureLeft		= 0;
+	triggerLevel	= false;
+	captureBuffer.commit(0);							// an old history does not belong to this capture
+	captureBuffer.dropped();
+}
 /**
- * @name getToken(PGM_P sourcePtr, char * destPtr, uint8_t token)
+ * @name triggerOnPin(uint8_t pin, uint16_t value)
+ * @param pin	pin number. A pin that is not in the test set removes the pin trigger
+ * @param value	value of the pin that fires the trigger
+ */
+void AutoTestBase::triggerOnPin(uint8_t pin, uint16_t value) {
+
+	triggerPinIndex	= getPinIndex(pin);
+	triggerValue	= value;
+}
+/**
+ * @name triggerOnTestCase(int testCase)
+ * @param testCase	number of the test case whose activation fires the trigger. -1 for none
+ */
+void AutoTestBase::triggerOnTestCase(int testCase) {
+
+	triggerTestCase = testCase;
+}
+/**
+ * @name triggerOn(bool (*condition)())
+ * @param condition	function of the sketch, called after every event, that returns true to fire the trigger. For a
+ * counter that extendSerialOut shows for example. It must not call the functions AutoTest reroutes. NULL for none
+ */
+void AutoTestBase::triggerOn(bool (*condition)()) {
+
+	triggerCondition = condition;
+}
+/**
+ * @name checkExpected(bool final)
+ * @param final	true if the check has to be decided now because the next test case is activated or the run ends
+ * Compares the output pins with the expected values of the test case being checked. The k-th expected value belongs
+ * to the k-th pin that is not an input, just like the input values belong to the input pins. Inside the check window
+ * the test case passes as soon as all the values match and fails if they do not match when the window closes.
+ * The result is an AUTOTEST_EVENT_PASS or an AUTOTEST_EVENT_FAIL with an AUTOTEST_EVENT_MISMATCH per wrong pin
+ */
+void AutoTestBase::checkExpected(bool final) {
+	bool	match = true;					// all output pins have their expected value
+	uint8_t	k = 0;							// index in expectedValues
+
+	if (!checkPending || (!final && clockMillis() < checkFrom)) {
+		return;
+	}
+	for (uint8_t i = 0; i < Number_Of_Pins && k < numberOfExpected; i++) {
+		if (!isInputPin(i)) {
+			if (expectedValues[k] != AUTOTEST_DONT_CARE && expectedValues[k] != getPinValue(i)) {
+				match = false;
+			}
+			k++;
+		}
+	}
+	if (match) {
+		checkPending = false;
+		testsPassed++;
+		traceEvent(AUTOTEST_EVENT_PASS, 0, checkTestCase);
+	} else if (final || clockMillis() >= checkTo) {
+		checkPending = false;
+		testsFailed++;
+		traceEvent(AUTOTEST_EVENT_FAIL, 0, checkTestCase);
+		k = 0;
+		for (uint8_t i = 0; i < Number_Of_Pins && k < numberOfExpected; i++) {
+			if (!isInputPin(i)) {
+				if (expectedValues[k] != AUTOTEST_DONT_CARE && expectedValues[k] != getPinValue(i)) {
+					traceEvent(AUTOTEST_EVENT_MISMATCH, i, ((unsigned long)expectedValues[k] << 16) | getPinValue(i));
+				}
+				k++;
+			}
+		}
+	}
+	if (!checkPending) {
+		sendResult();
+	}
+}
+/**
+ * @name sendResult()
+ * Sends the number of test cases that passed and failed once every test case is activated and checked. Only if
+ * the test set has expected values
+ */
+void AutoTestBase::sendResult() {
+
+	if (!resultSent && !checkPending && nextTestCaseNumber == 10000 && testsPassed + testsFailed != 0) {
+		resultSent = true;
+		traceEvent(AUTOTEST_EVENT_RESULT, 0, testsFailed);
+	}
+}
+/**
+ * @name finish()
+ * Ends the run. Sends the count of repeated reads that is still pending, decides the check of the last test case
+ * and sends the result. The host build calls this when it stops the sketch
+ */
+void AutoTestBase::finish() {
+
+	sendPendingReads();
+	checkExpected(true);
+	sendResult();
+}
+/**
+ * @name failedTestCases()
+ * @returns unsigned int	number of test cases that did not have their expected values
+ */
+unsigned int AutoTestBase::failedTestCases() {
+
+	return testsFailed;
+}
+/**
+ * @name traceRead(uint8_t pinIndex, uint16_t value)
+ * @param pinIndex	pin index of the pin read
+ * @param value		value read
+ * Sends the read. If reads are coalesced and this read repeats the read sent last, it is only counted
+ */
+void AutoTestBase::traceRead(uint8_t pinIndex, uint16_t value) {
+
+	if (coalesce && readRunPin == pinIndex && readRunValue == value) {
+		repeatedReads++;
+		lastReadTime = clockTime();
+		return;
+	}
+	traceEvent(AUTOTEST_EVENT_READ, pinIndex, value);
+	if (coalesce) {
+		readRunPin		= pinIndex;
+		readRunValue	= value;
+		readRunStart	= eventTime;
+	}
+}
+/**
+ * @name commitRecord()
+ * @returns bool	false if the record did not fit in the trace buffer
+ * Ends the record in the trace buffer and counts it if it was dropped. In delta mode the next record is a keyframe
+ * as the pins that changed in the dropped record are not known to the reader
+ */
+bool AutoTestBase::commitRecord() {
+
+	if (traceBuffer.commit()) {
+		return true;
+	}
+	if (pendingDropped != 0xFFFF) {
+		pendingDropped++;
+	}
+	droppedTotal++;
+	recordsToKeyframe = 0;
+	return false;
+}
+/**
+ * @name writeEvent(uint8_t type, uint8_t pin, unsigned long value)
+ * @param type	AUTOTEST_EVENT_...
+ * @param pin	pin index or the pin number for the INVALID events
+ * @param value	value of the pin, mode for AUTOTEST_EVENT_PIN_MODE or the test case number for AUTOTEST_EVENT_ACTIVATE
+ * Writes the event to output (Serial or the trace buffer) in the selected output mode
+ * \n AUTOTEST_OUTPUT_CSV		action text and all pin values (displayPins())
+ * \n AUTOTEST_OUTPUT_BINARY	a fixed size frame (see AUTOTEST_FRAME_LENGTH). decodeTrace on the host turns the frames into
+ * the same CSV using the generated headers
+ * \n AUTOTEST_OUTPUT_DELTA	a record with only the pins that changed since the previous record (sendDelta()). decodeTrace
+ * turns these into the same CSV as well
+ */
+void AutoTestBase::writeEvent(uint8_t type, uint8_t pin, unsigned long value) {
+
+	if (outputMode == AUTOTEST_OUTPUT_VERDICT && type != AUTOTEST_EVENT_PASS && type != AUTOTEST_EVENT_FAIL &&
+		type != AUTOTEST_EVENT_MISMATCH && type != AUTOTEST_EVENT_RESULT && type != AUTOTEST_EVENT_DROPPED &&
+		type != AUTOTEST_EVENT_ANALOG_FULL) {
+		return;
+	}
+	if (outputMode == AUTOTEST_OUTPUT_BINARY) {
+		sendFrame(type, pin, value);
+		return;
+	}
+	if (outputMode == AUTOTEST_OUTPUT_DELTA) {
+		//
+		// input and mode changes show up in the next record like they do in the CSV
+		//
+		if (type != AUTOTEST_EVENT_INPUT && type != AUTOTEST_EVENT_PIN_MODE && type != AUTOTEST_EVENT_PORT_PIN) {
+			sendDelta(type, pin, value);
+		}
+		return;
+	}
+	switch (type) {
+	case AUTOTEST_EVENT_READ:
+	case AUTOTEST_EVENT_WRITE:
+	case AUTOTEST_EVENT_ANALOG_WRITE:
+		//
+		// the action text is printed with the name straight from Flash
+		//
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		if (type == AUTOTEST_EVENT_READ) {
+			output->print(" read");
+		} else if (type == AUTOTEST_EVENT_WRITE) {
+			output->print(value == LOW ? " set to LOW" : " set to HIGH");
+		} else {
+			output->print(" set to ");
+			output->print(value);
+		}
+		displayPins();
+		break;
+	case AUTOTEST_EVENT_TRIGGER:
+		output->println("");
+		output->print("trigger, ");
+		output->print(value);
+		output->println(" earlier events not sent");
+		break;
+	case AUTOTEST_EVENT_INTERRUPT:
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		output->print(" interrupt");
+		displayPins();
+		break;
+	case AUTOTEST_EVENT_INVALID_INTERRUPT:
+		output->println("");
+		output->print("attachInterrupt(");
+		output->print(pin);
+		output->println(") invalid interrupt");
+		break;
+	case AUTOTEST_EVENT_PORT_WRITE:
+	case AUTOTEST_EVENT_PORT_READ:
+		output->println("");
+		output->print("port ");
+		output->print((char)('A' + pin - 1));		// PA is 1. The numbers skip 9 like the letters skip I
+		if (type == AUTOTEST_EVENT_PORT_READ) {
+			output->print(" read");
+		} else {
+			output->print(" set to ");
+			output->print(value);
+		}
+		displayPins();
+		break;
+	case AUTOTEST_EVENT_ACTIVATE:
+		//
+		// the action text is the test case description
+		//
+		output->println("");
+		if (packedTestCases != NULL) {
+			output->print((const __FlashStringHelper *)nextDescriptionPtr);
+		} else {
+			output->print(nextTestCaseDescription);
+		}
+		displayPins();
+		break;
+	case AUTOTEST_EVENT_INVALID_PIN_MODE:
+		output->println("");
+		output->print("pinMode (");
+		output->print(pin);
+		output->print(",");
+		output->print(value);
+		output->println(") invalid pin");
+		break;
+	case AUTOTEST_EVENT_INVALID_READ:
+		output->println("");
+		output->print("digitalRead(");
+		output->print(pin);
+		output->println(") invalid pin");
+		break;
+	case AUTOTEST_EVENT_INVALID_ANALOG_READ:
+		output->println("");
+		output->print("analogRead(");
+		output->print(pin);
+		output->println(") invalid pin");
+		break;
+	case AUTOTEST_EVENT_INVALID_WRITE:
+	case AUTOTEST_EVENT_INVALID_ANALOG_WRITE:
+		output->println("");
+		output->print("digitalWrite(");
+		output->print(pin);
+		output->print(",");
+		output->print(value);
+		output->println(") invalid pin");
+		break;
+	case AUTOTEST_EVENT_INVALID_VALUE:
+		output->println("");
+		output->print("digitalWrite(");
+		output->print(pin);
+		output->print(",");
+		output->print(value);
+		output->println(") error. Value sent is not HIGH or LOW");
+		break;
+	case AUTOTEST_EVENT_PASS:
+	case AUTOTEST_EVENT_FAIL:
+		output->println("");
+		output->print(type == AUTOTEST_EVENT_PASS ? "PASS" : "FAIL");
+		output->print(CSV_SEPARATOR);
+		output->print(value);
+		output->print(CSV_SEPARATOR);
+		output->print(checkDescription);
+		break;
+	case AUTOTEST_EVENT_MISMATCH:
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		output->print(" expected ");
+		output->print(value >> 16);
+		output->print(" got ");
+		output->print(value & 0xFFFF);
+		break;
+	case AUTOTEST_EVENT_RESULT:
+		output->println("");
+		output->print("RESULT");
+		output->print(CSV_SEPARATOR);
+		output->print(testsPassed);
+		output->print(CSV_SEPARATOR);
+		output->println(value);
+		break;
+	case AUTOTEST_EVENT_READ_REPEAT:
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		output->print(" read ");
+		output->print(value);
+		output->print(" more times over ");
+		output->print(lastReadTime - readRunStart);
+		output->println(" usec");
+		break;
+	case AUTOTEST_EVENT_LATENCY:
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		output->print(" responded after ");
+		output->print(value);
+		output->println(" usec");
+		break;
+	case AUTOTEST_EVENT_DROPPED:
+		output->println("");
+		output->print("trace buffer full, ");
+		output->print(value);
+		output->println(" records dropped");
+		break;
+	case AUTOTEST_EVENT_ANALOG_FULL:
+		output->println("");
+		output->print("pin ");
+		printPinName(output, pin);
+		output->print(" value ");
+		output->print(value);
+		output->println(" set to HIGH, no AUTOTEST_ANALOG_PINS left");
+		break;
+	default:
+		//
+		// AUTOTEST_EVENT_INPUT, _PIN_MODE and _PORT_PIN only change values. They show up in the next line
+		//
+		break;
+	}
+}
+/**
+ * @name sendFrame(uint8_t type, uint8_t pin, unsigned long value)
+ * @param type	AUTOTEST_EVENT_...
+ * @param pin	pin index or the pin number for the INVALID events
+ * @param value	value of the event
+ * Sends one binary frame. All numbers are little endian:
+ * \n byte 0		AUTOTEST_FRAME_SYNC
+ * \n byte 1		event type
+ * \n byte 2		pin index (pin number for the INVALID events)
+ * \n byte 3-4	value (0xFFFF if it is larger). For AUTOTEST_EVENT_MISMATCH byte 3 is the value of the pin and byte 4
+ * the expected value (0xFF if it is larger)
+ * \n byte 5-8	time in usec
+ * \n byte 9-10	number of the active test case (0xFFFF before the first one)
+ * \n byte 11	xor of byte 0-10 so the decoder can find the frames back after garbage
+ */
+void AutoTestBase::sendFrame(uint8_t type, uint8_t pin, unsigned long value) {
+	uint8_t			frame[AUTOTEST_FRAME_LENGTH];	// the frame to send
+	unsigned long	now = eventTime;				// time stamp
+	uint8_t			check = 0;						// check byte
+
+	if (type == AUTOTEST_EVENT_MISMATCH) {
+		value = (value & 0xFF) | ((value >> 16) > 0xFF ? 0xFF00 : (value >> 8) & 0xFF00);
+	} else if (value > 0xFFFF) {
+		value = 0xFFFF;
+	}
+	frame[0]	= AUTOTEST_FRAME_SYNC;
+	frame[1]	= type;
+	frame[2]	= pin;
+	frame[3]	= value;
+	frame[4]	= value >> 8;
+	frame[5]	= now;
+	frame[6]	= now >> 8;
+	frame[7]	= now >> 16;
+	frame[8]	= now >> 24;
+	frame[9]	= activeTestCaseNumber;
+	frame[10]	= activeTestCaseNumber >> 8;
+	for (uint8_t i = 0; i < AUTOTEST_FRAME_LENGTH - 1; i++) {
+		check ^= frame[i];
+	}
+	frame[11]	= check;
+	for (uint8_t i = 0; i < AUTOTEST_FRAME_LENGTH; i++) {
+		writeBinary(frame[i]);
+	}
+}
+/**
+ * @name sendDelta(uint8_t type, uint8_t pin, unsigned long value)
+ * @param type	AUTOTEST_EVENT_...
+ * @param pin	pin index or the pin number for the INVALID events
+ * @param value	value of the event
+ * Sends a record with the pins that changed since the previous record. Numbers marked (n) are sent in groups of
+ * 7 bits, lowest first, with bit 7 set if another group follows. So a value below 128 takes one byte.
+ * \n delta record:
+ * \n AUTOTEST_DELTA_SYNC, type, pin, value (n), usec since the previous record (n),
+ * change mask (1 bit per pin, 8 pins per byte), new value of each changed pin (n), check byte
+ * \n keyframe, sent at every test case activation and after keyframeInterval delta records:
+ * \n AUTOTEST_KEYFRAME_SYNC, type, pin, value (n), time in usec (4 bytes), active test case (2 bytes),
+ * value of every pin (n), check byte
+ * \n The check byte is the xor of all the other bytes. A reader can start at any keyframe.
+ */
+void AutoTestBase::sendDelta(uint8_t type, uint8_t pin, unsigned long value) {
+	unsigned long	now = eventTime;				// time stamp
+
+	recordCheck = 0;
+	if (recordsToKeyframe == 0 || type == AUTOTEST_EVENT_ACTIVATE) {
+		//
+		// keyframe with all the pins
+		//
+		putByte(AUTOTEST_KEYFRAME_SYNC);
+		putByte(type);
+		putByte(pin);
+		putNumber(value);
+		putByte(now);
+		putByte(now >> 8);
+		putByte(now >> 16);
+		putByte(now >> 24);
+		putByte(activeTestCaseNumber);
+		putByte(activeTestCaseNumber >> 8);
+		for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+			putNumber(getPinValue(i));
+		}
+		recordsToKeyframe = keyframeInterval;
+	} else {
+		putByte(AUTOTEST_DELTA_SYNC);
+		putByte(type);
+		putByte(pin);
+		putNumber(value);
+		putNumber(now - lastRecordTime);
+		//
+		// which pins changed
+		//
+		for (uint8_t group = 0; group < AUTOTEST_PIN_BITS(Number_Of_Pins); group++) {
+			putByte(changedPins(group));
+		}
+		//
+		// and their new values
+		//
+		for (uint8_t group = 0; group < AUTOTEST_PIN_BITS(Number_Of_Pins); group++) {
+			uint8_t mask = changedPins(group);
+
+			for (uint8_t bit = 0; mask != 0; bit++, mask >>= 1) {
+				if (mask & 1) {
+					putNumber(getPinValue((group << 3) + bit));
+				}
+			}
+		}
+		recordsToKeyframe--;
+	}
+	//
+	// the record holds all the values now
+	//
+	memcpy(sentDigitalBits, digitalBits, AUTOTEST_PIN_BITS(Number_Of_Pins));
+	memcpy(sentAnalogValues, analogValues, numberOfAnalog * sizeof(uint16_t));
+	lastRecordTime = now;
+	writeBinary(recordCheck);
+}
+/**
+ * @name putByte(uint8_t data)
+ * @param data	byte to send
+ * Sends a byte of a delta record and adds it to the check byte
+ */
+void AutoTestBase::putByte(uint8_t data) {
+
+	recordCheck ^= data;
+	writeBinary(data);
+}
+/**
+ * @name putNumber(unsigned long number)
+ * @param number	number to send
+ * Sends a number in groups of 7 bits. Bit 7 is set when another group follows
+ */
+void AutoTestBase::putNumber(unsigned long number) {
+
+	while (number >= 0x80) {
+		putByte((number & 0x7F) | 0x80);
+		number >>= 7;
+	}
+	putByte(number);
+}
+/**
+ * @name writeBinary(uint8_t data)
+ * @param data	byte of a binary frame or delta record
+ * Writes the byte to the output. While test cases are streamed the request and escape bytes are escaped, so the
+ * feeder cannot take a data byte for a request (see AUTOTEST_STREAM_ESCAPE)
+ */
+void AutoTestBase::writeBinary(uint8_t data) {
+
+	if (testCaseStream != NULL && (data == AUTOTEST_STREAM_REQUEST || data == AUTOTEST_STREAM_ESCAPE)) {
+		output->write((uint8_t)AUTOTEST_STREAM_ESCAPE);
+		data ^= 0x20;
+	}
+	output->write(data);
+}
+/**
+ * @name setOutputMode(uint8_t mode)
+ * @param mode	AUTOTEST_OUTPUT_CSV (default), AUTOTEST_OUTPUT_BINARY or AUTOTEST_OUTPUT_DELTA
+ * In binary and delta mode each event is a small record instead of a line of text. The extendSerialOut function
+ * is not called as its text would mix with the records. Each record carries a time stamp instead.
+ */
+void AutoTestBase::setOutputMode(uint8_t mode) {
+
+	outputMode 			= mode;
+	recordsToKeyframe	= 0;				// a reader needs a keyframe to start with
+}
+/**
+ * @name setKeyframeInterval(uint8_t records)
+ * @param records	number of delta records between two keyframes (default AUTOTEST_KEYFRAME_INTERVAL)
+ * A keyframe is also sent at every test case activation
+ */
+void AutoTestBase::setKeyframeInterval(uint8_t records) {
+
+	keyframeInterval = records;
+}
+/**
+ * @name flush()
+ * @returns bool	true if there are still records in the trace buffer
+ * Sends as much of the trace buffer as Serial takes without waiting. Called from yield() (see AutomaticTesting.h)
+ * and callDelay(). A sketch that does not wait can call it itself
+ */
+bool AutoTestBase::flush() {
+
+	if (output == &Serial) {
+		return false;
+	}
+	traceBuffer.drain(Serial);
+	return !traceBuffer.empty();
+}
+/**
+ * @name droppedRecords()
+ * @returns unsigned long	number of records that did not fit in the trace buffer since the start
+ */
+unsigned long AutoTestBase::droppedRecords() {
+
+	return droppedTotal;
+}
+/**
+ * @name printPinName(Print *port, uint8_t pinIndex)
+ * @param port		where to print it
+ * @param pinIndex	pin index
+ * Prints the name of the pin from pinHeaders in Flash, so the names do not take RAM
+ */
+void AutoTestBase::printPinName(Print *port, uint8_t pinIndex) {
+
+	PGM_P	namePtr = pinHeaders + pinNames[pinIndex];	// first character of the name
+	char	c;
+
+	while ((c = pgm_read_byte(namePtr++)) != '\n' && c != '\0') {
+		port->write(c);
+	}
+}
+/**
+ * @name displayPins()
+ * Ends the line of CSV the caller started with the action text: the values of all the pins
+ */
+void AutoTestBase::displayPins() {
+
+	output->print(CSV_SEPARATOR);
+	//
+	// check each pin if it is defined in the program. Defined means it was programmed through pinMode()
+	//
+	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+		output->print(getPinValue(i));	// print Value
+		output->print(CSV_SEPARATOR);				// print a separator
+	}
+	//
+	// check if the user wants more output
+	//
+	if (callExtendDisplayPins != NULL && output != &captureBuffer) {
+		//
+		// the user function prints to Serial itself so everything in the trace buffer has to go first. Its text
+		// cannot be kept in the history before a trigger
+		//
+		if (output != &Serial) {
+			if (!commitRecord()) {
+				return;
+			}
+			while (flush()) {
+			}
+		}
+		callExtendDisplayPins();					// allow the user to extend the info to serial
+	}
+}
+/**
+ * @name getTestCase()
+ * @returns testCaseAvailable 0 = no more test cases 1 = still testcases
+ * Reads the testcase if there is one and returns 1. Otherwise returns 0
+ *
+ */
+uint8_t AutoTestBase::getTestCase(){
+
+	uint8_t  returnCode;				// result of this operation
+	char	 pinValue[5];				// value of pin as a string (could be 0-1023
+	char	 inputField[AUTOTEST_INPUT_FIELD];	// input value or generator as a string
+	char	 delayTime[10];				// delay time as string
+	uint16_t recordLength;				// returns the length of a record in testcases
+
+	//
+	// check if there is any testcase left
+	//
+	if (nextTestCaseNumber >= 10000) {
+		//
+		// limit reached
+		//
+		nextTestCaseNumber = 10000;
+		returnCode = 1;
+	} else if (testCaseStream != NULL && nextTestCaseNumber == 9999) {
+		//
+		// a stream has no limit, the numbers start again
+		//
+		nextTestCaseNumber = 0;
+	} else {
+		nextTestCaseNumber++;
+	}
+	//
+	// anything to process
+	//
+	if (nextTestCaseNumber < 10000 && packedTestCases != NULL) {
+		//
+		// the test cases are already in binary form
+		//
+		returnCode = getPackedTestCase();
+	} else if (nextTestCaseNumber < 10000 && testCaseStream != NULL) {
+		//
+		// the test cases come in over Serial
+		//
+		returnCode = getStreamTestCase();
+	} else if (nextTestCaseNumber < 10000) {
+		//
+		// check if we have a test case
+		//
+		recordLength = getRecordLength(testCasePtr);
+		if (recordLength != 0) {
+			//
+			// we have a testcase So let's get it
+			//
+			// Get description
+			//
+			testCasePtr = getToken(testCasePtr, nextTestCaseDescription, ',');
+			//
+			// get the test case values
+			//
+			for(uint8_t i = 0; i < Number_Of_Input_Pins; i++) {
+				//
+				// copy the values from the FLASH memory
+				//
+				testCasePtr = getField(testCasePtr, inputField, sizeof(inputField));
+				//
+				// convert the sting to an int (or a generator) and put in the nextInputValues array
+				//
+				setInputValue(i, inputField);
+			}
+			//
+			// get the delay time of this test case
+			//
+			testCasePtr 		= getField(testCasePtr, delayTime, sizeof(delayTime));
+			activationDelay 	= atol(delayTime);
+			activateTestCase 	= clockMillis() + activationDelay;
+			//
+			// the record can end with the check window and the expected value of each output pin
+			// (in the order of pinHeaders.h). x or an empty field is not checked
+			//
+			nextNumberOfExpected = 0;
+			if (pgm_read_byte(testCasePtr) != '\n') {
+				testCasePtr		= getField(testCasePtr, delayTime, sizeof(delayTime));
+				nextCheckFrom	= atol(delayTime);
+				testCasePtr		= getField(testCasePtr, delayTime, sizeof(delayTime));
+				nextCheckTo		= atol(delayTime);
+				while (pgm_read_byte(testCasePtr) != '\n' && nextNumberOfExpected < maxExpected) {
+					testCasePtr = getField(testCasePtr, pinValue, sizeof(pinValue));
+					nextExpectedValues[nextNumberOfExpected++] =
+						pinValue[0] >= '0' && pinValue[0] <= '9' ? atoi(pinValue) : AUTOTEST_DONT_CARE;
+				}
+				//
+				// skip what does not fit
+				//
+				testCasePtr = strchr_P(testCasePtr, '\n');
+			}
+			testCasePtr++;						// past the end of the record
+			//
+			// set the return code
+			//
+			returnCode = 1;
+
+		} else {
+			//
+			// no more testcases
+			//
+			nextTestCaseNumber = 10000;
+			returnCode = 0;
+		}
+	} else {
+		//
+		// no more test cases
+		//
+		returnCode = 0;
+	}
+	return returnCode;
+}
+
+/**
+ * @name getPackedTestCase()
+ * @returns testCaseAvailable 0 = no more test cases 1 = still testcases
+ * Loads test case nextTestCaseNumber from the packed records. Each record is AUTOTEST_PACKED_RECORD_WORDS words:
+ * \n word 0-1	activation delay in msec (low word first)
+ * \n word 2	offset of the description in testCaseDescriptions
+ * \n word 3-	value for each input pin
+ * As the records have a fixed size every field is fetched directly. No scanning or conversion is needed
+ */
+uint8_t AutoTestBase::getPackedTestCase() {
+
+	const uint16_t	*recordPtr;				// points to the record in Flash memory
+
+	if ((unsigned int)nextTestCaseNumber >= numberOfPackedTestCases) {
+		//
+		// no more testcases
+		//
+		nextTestCaseNumber = 10000;
+		return 0;
+	}
+	recordPtr = packedTestCases + (unsigned int)nextTestCaseNumber * AUTOTEST_PACKED_RECORD_WORDS(Number_Of_Input_Pins);
+	//
+	// get the delay and the description
+	//
+	activationDelay 		= pgm_read_word(recordPtr) | ((unsigned long)pgm_read_word(recordPtr + 1) << 16);
+	nextDescriptionPtr		= testCaseDescriptions + pgm_read_word(recordPtr + 2);
+	nextNumberOfExpected	= 0;		// packed records have no expected values, packTestCases refuses them
+	//
+	// get the test case values
+	//
+	recordPtr += 3;
+	for (uint8_t i = 0; i < Number_Of_Input_Pins; i++) {
+		nextInputValues[i] = pgm_read_word(recordPtr + i);
+		if (nextGenerators != NULL) {
+			nextGenerators[i].type = AUTOTEST_GENERATOR_NONE;
+		}
+	}
+	activateTestCase 		= clockMillis() + activationDelay;
+	return 1;
+}
+
+#ifdef AUTOTEST_HOST
+/**
+ * @name startPackedTestCases(const uint16_t *records, PGM_P descriptions, unsigned int count)
+ * @param records		packed test case records (see getPackedTestCase())
+ * @param descriptions	the descriptions the records point to
+ * @param count			number of records
+ * Starts over with other test cases without reading the pins again. The fuzzing harness of the host build
+ * (host/fuzz/fuzzSketch.cpp) gives every run its own records this way
+ */
+void AutoTestBase::startPackedTestCases(const uint16_t *records, PGM_P descriptions, unsigned int count) {
+
+	packedTestCases			= records;
+	testCaseDescriptions	= descriptions;
+	numberOfPackedTestCases	= count;
+	nextTestCaseNumber		= -1;
+	getTestCase();
+}
+#endif
+/**
+ * @name registerState(void *block, size_t size)
+ * @param block		variables of the sketch, a struct for example
+ * @param size		bytes in block
+ * Makes the variables part of the checkpoints of the host build (see saveState()). Call it at the start of setup().
+ * On the board there are no checkpoints and this does nothing
+ */
+void AutoTestBase::registerState(void *block, size_t size) {
+#ifdef AUTOTEST_HOST
+	if (numberOfStateBlocks < AUTOTEST_STATE_BLOCKS) {
+		stateBlocks[numberOfStateBlocks]		= block;
+		stateBlockSizes[numberOfStateBlocks++]	= size;
+	}
+#else
+	(void)block;
+	(void)size;
+#endif
+}
+#ifdef AUTOTEST_HOST
+/**
+ * @name stateSize()
+ * @returns size_t	bytes saveState() writes
+ */
+size_t AutoTestBase::stateSize() {
+	size_t size = 1;									// the number of blocks
+
+	for (uint8_t i = 0; i < numberOfStateBlocks; i++) {
+		size += stateBlockSizes[i];
+	}
+	return size;
+}
+/**
+ * @name stateBlockCount()
+ * @returns uint8_t	number of blocks registered so far. main() of the host build compares it before and after setup()
+ * to see if the sketch registered its variables
+ */
+uint8_t AutoTestBase::stateBlockCount() {
+
+	return numberOfStateBlocks;
+}
+/**
+ * @name saveState(uint8_t *state)
+ * @param state		stateSize() bytes
+ * Saves a checkpoint: AutoTest with the pin values and modes, the test case cursor, the pending activation and the
+ * virtual clock, and the variables registered by the sketch. Take it between two passes of loop(), the sketch cannot
+ * be stopped halfway. A trace buffer is saved with what it did not send yet
+ */
+void AutoTestBase::saveState(uint8_t *state) {
+	*state++ = numberOfStateBlocks;
+	for (uint8_t i = 0; i < numberOfStateBlocks; i++) {
+		memcpy(state, stateBlocks[i], stateBlockSizes[i]);
+		state += stateBlockSizes[i];
+	}
+}
+/**
+ * @name restoreState(const uint8_t *state)
+ * @param state		a checkpoint from saveState()
+ * @returns bool	false if variables were registered after the checkpoint was saved, nothing is restored then
+ * Goes back to the checkpoint. The output sent since then is not taken back
+ */
+bool AutoTestBase::restoreState(const uint8_t *state) {
+	uint8_t blocks = numberOfStateBlocks;				// the first block overwrites the list with the same list
+
+	if (*state++ != blocks) {
+		return false;
+	}
+	for (uint8_t i = 0; i < blocks; i++) {
+		void	*block	= stateBlocks[i];
+		size_t	size	= stateBlockSizes[i];
+
+		memcpy(block, state, size);
+		state += size;
+	}
+	return true;
+}
+/**
+ * @name pendingTestCase()
+ * @returns int		number of the test case that is activated next, 10000 if all test cases are activated
+ */
+int AutoTestBase::pendingTestCase() {
+	return nextTestCaseNumber;
+}
+/**
+ * @name continueTestCases(PGM_P records)
+ * @param records	CSV records, ended by an empty line
+ * The test case after the pending one is read from records. With restoreState() a test set that starts with the
+ * same test cases as another one continues from a checkpoint of that one, up to and including the pending test case
+ */
+void AutoTestBase::continueTestCases(PGM_P records) {
+	testCasePtr = records;
+}
+#endif
+/**
+ * @name getStreamTestCase()
+ * @returns testCaseAvailable 0 = no more test cases 1 = still testcases
+ * Loads the next test case from the record buffer that was filled first. The records have the same format as in
+ * TestCases.h and an empty record ends the test set. The record buffer is then free and the feeder is asked for the
+ * next record, so while this test case waits for its activation the one after it is already coming in.
+ * If the record did not arrive yet the test case is not activated until it does (activateNextTestCase() calls this
+ * again). On the host the virtual clock stands still, so waiting for the feeder does not change the test
+ */
+uint8_t AutoTestBase::getStreamTestCase() {
+
+	char	*record;						// the record in RAM
+	char	*field;							// field being read
+
+	pollStream();
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	unsigned long waitStart = millis();		// real time, the feeder is a real program
+
+	while (!streamReady[streamRead] && millis() - waitStart < AUTOTEST_STREAM_TIMEOUT) {
+		delayMicroseconds(50);
+		pollStream();
+	}
+	if (!streamReady[streamRead]) {
+		//
+		// the feeder is gone. Same as the end of the test set
+		//
+		streamBuffer[streamRead * streamRecordLength] = '\0';
+		streamReady[streamRead] = true;
+	}
+#endif
+	if (!streamReady[streamRead]) {
+		streamWaiting 		= true;
+		activateTestCase	= 0xFFFFFFFFUL;		// not before it is there
+		return 1;
+	}
+	streamWaiting	= false;
+	record			= &streamBuffer[streamRead * streamRecordLength];
+	if (record[0] == '\0') {
+		//
+		// no more testcases
+		//
+		nextTestCaseNumber = 10000;
+		return 0;
+	}
+	//
+	// description, input values and delay like getTestCase()
+	//
+	field = strsep(&record, ",");
+	strncpy(nextTestCaseDescription, field, sizeof(nextTestCaseDescription) - 1);
+	nextTestCaseDescription[sizeof(nextTestCaseDescription) - 1] = '\0';
+	for (uint8_t i = 0; i < Number_Of_Input_Pins; i++) {
+		field = strsep(&record, ",");
+		setInputValue(i, field != NULL ? field : "0");
+	}
+	field = strsep(&record, ",");
+	activationDelay 	= field != NULL ? atol(field) : 0L;
+	activateTestCase 	= clockMillis() + activationDelay;
+	//
+	// the check window and the expected values
+	//
+	nextNumberOfExpected = 0;
+	if (record != NULL) {
+		field			= strsep(&record, ",");
+		nextCheckFrom	= atol(field);
+		field			= strsep(&record, ",");
+		nextCheckTo		= field != NULL ? atol(field) : 0L;
+		while (record != NULL && nextNumberOfExpected < maxExpected) {
+			field = strsep(&record, ",");
+			nextExpectedValues[nextNumberOfExpected++] =
+				field[0] >= '0' && field[0] <= '9' ? atoi(field) : AUTOTEST_DONT_CARE;
+		}
+	}
+	//
+	// the buffer is free for the record after the next one
+	//
+	streamReady[streamRead]	= false;
+	streamRead				^= 1;
+	requestStreamRecord();
+	return 1;
+}
+
+/**
+ * @name pollStream()
+ * Moves the bytes that arrived into the record buffer being filled, until that buffer holds a complete record.
+ * Bytes that do not fit in the buffer are skipped up to the end of the record. Nothing is read while both buffers
+ * are full so the feeder (and the serial receive buffer) cannot overrun AutoTest
+ */
+void AutoTestBase::pollStream() {
+
+	char	*record = &streamBuffer[streamWrite * streamRecordLength];	// the buffer being filled
+	int		c;
+
+	while (!streamReady[streamWrite] && testCaseStream->available() > 0) {
+		c = testCaseStream->read();
+		if (c == '\n') {
+			record[streamFill]			= '\0';
+			streamReady[streamWrite]	= true;
+			streamWrite					^= 1;
+			streamFill					= 0;
+			record						= &streamBuffer[streamWrite * streamRecordLength];
+		} else if (c != '\r' && streamFill < streamRecordLength - 1) {
+			record[streamFill++] = c;
+		}
+	}
+}
+
+/**
+ * @name requestStreamRecord()
+ * Sends AUTOTEST_STREAM_REQUEST to the feeder for each free record buffer. It goes to Serial directly so it is not
+ * held up behind the trace buffer
+ */
+void AutoTestBase::requestStreamRecord() {
+
+	testCaseStream->write((uint8_t)AUTOTEST_STREAM_REQUEST);
+#ifdef AUTOTEST_HOST
+	testCaseStream->flush();			// stdout is buffered on the host
+#endif
+}
+
+/**
+ * @name setInputValue(uint8_t input, const char *field)
+ * @param input	number of the input value in the test case
+ * @param field	the input field of the test case record: a number or a generator (see AUTOTEST_ANALOG_GENERATORS)
+ * Without generators only the number at the start of a generator field is used
+ */
+void AutoTestBase::setInputValue(uint8_t input, const char *field) {
+
+	AutoTestGenerator	*generator;			// generator of this input
+	bool				isGenerator = field[0] != '\0' && strchr("rsqtn", field[0]) != NULL;
+
+	nextInputValues[input] = atoi(isGenerator ? field + 1 : field);
+	if (nextGenerators == NULL) {
+		return;
+	}
+	generator		= &nextGenerators[input];
+	generator->type	= isGenerator ? field[0] : AUTOTEST_GENERATOR_NONE;
+	if (!isGenerator) {
+		return;
+	}
+	memset(generator->parameter, 0, sizeof(generator->parameter));
+	field++;
+	for (uint8_t i = 0; i < 3; i++) {
+		char *end;							// first character after the number
+
+		generator->parameter[i] = strtoul(field, &end, 10);
+		if (*end != ':') {
+			break;							// missing parameters are 0
+		}
+		field = end + 1;
+	}
+}
+
+/**
+ * @name generatorValue(uint8_t pinIndex)
+ * @param pinIndex	pin index of an input pin with a generator
+ * @returns uint16_t	value of the generator at this moment, kept between 0 and 65534
+ * The value only depends on the time since the activation, so the same test case gives the same values however
+ * often the sketch reads the pin
+ */
+uint16_t AutoTestBase::generatorValue(uint8_t pinIndex) {
+
+	AutoTestGenerator	*generator = &generators[pinIndex];
+	unsigned long		time = clockMillis() - generator->start;	// msec since activation
+	unsigned long		period = generator->parameter[2];			// msec of a ramp, step or period
+	uint32_t			seed;				// 32 bit so the board and the host give the same noise
+	float				value;
+
+	switch (generator->type) {
+	case AUTOTEST_GENERATOR_RAMP:
+		if (time >= period) {
+			return generator->parameter[1];
+		}
+		value = generator->parameter[0] + ((float)generator->parameter[1] - generator->parameter[0]) * time / period;
+		break;
+	case AUTOTEST_GENERATOR_SINE:
+		value = period == 0 ? generator->parameter[0] :
+				generator->parameter[0] + generator->parameter[1] * sin(2 * M_PI * (time % period) / period);
+		break;
+	case AUTOTEST_GENERATOR_SQUARE:
+		return period == 0 || time % period < period / 2 ? generator->parameter[0] : generator->parameter[1];
+	case AUTOTEST_GENERATOR_STEP:
+		return time < period ? generator->parameter[0] : generator->parameter[1];
+	case AUTOTEST_GENERATOR_NOISE:
+		//
+		// xorshift of the seed and the msec, so each msec has its own value
+		//
+		seed = (uint32_t)(period + 1) * 2654435761UL ^ (uint32_t)time;
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+		value = (float)generator->parameter[0] - generator->parameter[1] + seed % (2UL * generator->parameter[1] + 1);
+		break;
+	default:
+		return getPinValue(pinIndex);
+	}
+	if (value < 0) {
+		return 0;
+	}
+	return value > 65534.0 ? 65534 : (uint16_t)(value + 0.5);
+}
+
+/**
+ * @name getRecordlength ()
+ * @param ptr points to a memory locationin flash Memeory
+ * @returns int length of the record
+ * This function returns the number of bytes to the next newline character from ptr location
+ */
+int AutoTestBase::getRecordLength(PGM_P ptr) {
+	//
+	// find the newline character in Flash
+	//
+	PGM_P temp = strchr_P (ptr, '\n');
+	//
+	// return the difference
+	//
+	return temp - ptr;
+}
+
+/**
+ * @name getToken(PGM_P sourcePtr, char * destPtr, uint8_t token)
  * @param sourcePtr	Source in Flash memory
  * @param destPtr	Destination in RAM
  * @param token		token to be scanned for
@@ -643,7 +2138,7 @@ int AutoTest::getRecordLength(PGM_P ptr) {
  * Checks the string in Flahs Memory if it finds the requested token.
  * Once found, it will copy all data up to the token and terminate it with a '\0'
  */
-PGM_P AutoTest::getToken(PGM_P sourcePtr, char * destPtr, uint8_t token) {
+PGM_P AutoTestBase::getToken(PGM_P sourcePtr, char * destPtr, uint8_t token) {
 	PGM_P tempPtr;			// temporary pointer
 	unsigned int length;	// length of the field
 	//
@@ -668,20 +2163,54 @@ PGM_P AutoTest::getToken(PGM_P sourcePtr, char * destPtr, uint8_t token) {
 	tempPtr++;
 	return tempPtr; 		// return the next byte after the token
 }
+/**
+ * @name getField(PGM_P sourcePtr, char *destPtr, uint8_t size)
+ * @param sourcePtr	field of a test case record in Flash
+ * @param destPtr	destination in RAM
+ * @param size		size of destPtr. Longer fields are cut off
+ * @returns PGM_P	pointer after the ',' that ends the field or to the '\n' that ends the record
+ * Like getToken() but it stops at the end of the record, so fields that are not there are empty
+ */
+PGM_P AutoTestBase::getField(PGM_P sourcePtr, char *destPtr, uint8_t size) {
+	uint8_t	length = 0;						// characters copied
+	char	c;								// character in Flash
+
+	while ((c = pgm_read_byte(sourcePtr)) != ',' && c != '\n' && c != '\0') {
+		if (length < size - 1) {
+			destPtr[length++] = c;
+		}
+		sourcePtr++;
+	}
+	destPtr[length] = '\0';
+	return c == ',' ? sourcePtr + 1 : sourcePtr;
+}
 /**
  * @name getPinIndex(uint8_t pin)
  * @param pin pin number to search for
- * @returns uint8_t with the index in pinMap.
- * Searches pinMap for the pin and returns the index of it in pinMap. If not found, the first index out of range is returned
+ * @returns uint8_t with the pin index.
+ * Returns the index of the pin in the pin table. If not found, the first index out of range is returned
+ * This is called for every intercepted read and write so it takes constant time. Only with AUTOTEST_LINEAR_PIN_LOOKUP
+ * pinNumbers is searched.
  */
-uint8_t AutoTest::getPinIndex(uint8_t pin) {
+uint8_t AutoTestBase::getPinIndex(uint8_t pin) {
 
+#if defined(AUTOTEST_COMPACT_PIN_LOOKUP)
+	uint8_t bits = pinBits[pin >> 3];				// pins in the same group of 8
+	uint8_t mask = 1 << (pin & 7);					// bit for this pin
+	//
+	// if the bit is not set, the pin is not in the test set. Otherwise count the pins below it to get the rank
+	//
+	if ((bits & mask) == 0) {
+		return Number_Of_Pins;
+	}
+	return rankToIndex[pinRank[pin >> 3] + __builtin_popcount(bits & (mask - 1))];
+#elif defined(AUTOTEST_LINEAR_PIN_LOOKUP)
 	uint8_t returnPin = Number_Of_Pins;				// first pin out of range
 	//
 	// search the array
 	//
 	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
-		if (pinMap[(i * 2)] == pin) {
+		if (pinNumbers[i] == pin) {
 			//
 			// found it and save i for the exit
 			//
@@ -693,12 +2222,189 @@ uint8_t AutoTest::getPinIndex(uint8_t pin) {
 	// return the found value or the out of bounds value
 	//
 	return returnPin;
+#else
+	return pinIndexTable[pin];
+#endif
+}
+/**
+ * @name buildPinIndex()
+ * Fills the lookup from pin number to pin index once pinNumbers is loaded. If a pin appears twice in the test set
+ * the first one is used (like the linear search did)
+ */
+void AutoTestBase::buildPinIndex() {
+
+#if defined(AUTOTEST_COMPACT_PIN_LOOKUP)
+	uint8_t rank = 0;								// number of pins in the groups so far
+	//
+	// mark all pins in the bitset
+	//
+	memset(pinBits, 0, sizeof(pinBits));
+	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+		pinBits[pinNumbers[i] >> 3] |= 1 << (pinNumbers[i] & 7);
+	}
+	//
+	// count the pins before each group of 8
+	//
+	for (uint8_t i = 0; i < sizeof(pinRank); i++) {
+		pinRank[i] 	= rank;
+		rank 		+= __builtin_popcount(pinBits[i]);
+	}
+	//
+	// and store the index for each rank. Going backwards makes the first entry of a double pin win
+	//
+	for (uint8_t i = Number_Of_Pins; i-- > 0; ) {
+		uint8_t pin = pinNumbers[i];
+		rankToIndex[pinRank[pin >> 3] + __builtin_popcount(pinBits[pin >> 3] & ((1 << (pin & 7)) - 1))] = i;
+	}
+#elif !defined(AUTOTEST_LINEAR_PIN_LOOKUP)
+	//
+	// every pin not in the test set gets the out of range index. Going backwards makes the first entry of a double pin win
+	//
+	memset(pinIndexTable, Number_Of_Pins, sizeof(pinIndexTable));
+	for (uint8_t i = Number_Of_Pins; i-- > 0; ) {
+		pinIndexTable[pinNumbers[i]] = i;
+	}
+#endif
+}
+/**
+ * @name isInputPin(uint8_t pinIndex)
+ * @param pinIndex	pin index
+ * @returns bool	true if the mode of the pin is INPUT or INPUT_PULLUP
+ */
+bool AutoTestBase::isInputPin(uint8_t pinIndex) {
+
+	return (inputPinBits[pinIndex >> 3] >> (pinIndex & 7)) & 1;
+}
+/**
+ * @name analogSlot(uint8_t pinIndex)
+ * @param pinIndex	pin index
+ * @returns uint8_t	index in analogValues of the pin: the number of analog pins before it
+ */
+uint8_t AutoTestBase::analogSlot(uint8_t pinIndex) {
+
+	uint8_t slot = 0;					// analog pins in the groups before the pin
+
+	for (uint8_t group = 0; group < pinIndex >> 3; group++) {
+		slot += __builtin_popcount(analogPinBits[group]);
+	}
+	return slot + __builtin_popcount(analogPinBits[pinIndex >> 3] & ((1 << (pinIndex & 7)) - 1));
+}
+/**
+ * @name getPinValue(uint8_t pinIndex)
+ * @param pinIndex	pin index
+ * @returns uint16_t	value of the pin
+ */
+uint16_t AutoTestBase::getPinValue(uint8_t pinIndex) {
+
+	uint8_t mask = 1 << (pinIndex & 7);	// bit of the pin in its group
+
+	if (analogPinBits[pinIndex >> 3] & mask) {
+		return analogValues[analogSlot(pinIndex)];
+	}
+	return (digitalBits[pinIndex >> 3] & mask) != 0;
+}
+/**
+ * @name setPinValue(uint8_t pinIndex, uint16_t value)
+ * @param pinIndex	pin index
+ * @param value		new value of the pin
+ * @returns bool	true if the value changed
+ * A digital pin that gets a value other than 0 or 1 becomes an analog pin and stays one until begin(). Its slot is
+ * inserted in analogValues at its place in the pin order. If all AUTOTEST_ANALOG_PINS are in use the pin is set HIGH
+ * and AUTOTEST_EVENT_ANALOG_FULL is sent
+ */
+bool AutoTestBase::setPinValue(uint8_t pinIndex, uint16_t value) {
+
+	uint8_t		group	= pinIndex >> 3;	// byte of the pin in the bit tables
+	uint8_t		mask	= 1 << (pinIndex & 7);
+	uint8_t		slot;						// index in analogValues
+	bool		changed;
+
+	if ((analogPinBits[group] & mask) == 0) {
+		if (value <= 1) {
+			changed = ((digitalBits[group] & mask) != 0) != value;
+			if (changed) {
+				digitalBits[group] ^= mask;
+			}
+			return changed;
+		}
+		if (numberOfAnalog == maxAnalog) {
+			traceEvent(AUTOTEST_EVENT_ANALOG_FULL, pinIndex, value);
+			return setPinValue(pinIndex, HIGH);
+		}
+		//
+		// make room for the pin. The slot starts with the value the pin had and was sent with
+		//
+		slot = analogSlot(pinIndex);
+		memmove(&analogValues[slot + 1], &analogValues[slot], (numberOfAnalog - slot) * sizeof(uint16_t));
+		memmove(&sentAnalogValues[slot + 1], &sentAnalogValues[slot], (numberOfAnalog - slot) * sizeof(uint16_t));
+		analogValues[slot]		= (digitalBits[group] & mask) != 0;
+		sentAnalogValues[slot]	= (sentDigitalBits[group] & mask) != 0;
+		analogPinBits[group]	|= mask;
+		numberOfAnalog++;
+	} else {
+		slot = analogSlot(pinIndex);
+	}
+	changed				= analogValues[slot] != value;
+	analogValues[slot]	= value;
+	return changed;
+}
+/**
+ * @name changedPins(uint8_t group)
+ * @param group		pins group * 8 up to group * 8 + 7
+ * @returns uint8_t	bit per pin that has a different value than in the last delta record
+ * The digital pins of a group are compared in one go, only the analog pins one by one
+ */
+uint8_t AutoTestBase::changedPins(uint8_t group) {
+
+	uint8_t	analog	= analogPinBits[group];			// analog pins of the group
+	uint8_t	mask	= (digitalBits[group] ^ sentDigitalBits[group]) & ~analog;
+	uint8_t	slot;									// index in analogValues of the next analog pin
+
+	if (analog != 0) {
+		slot = analogSlot(group << 3);
+		for (uint8_t bit = 0; bit < 8; bit++) {
+			if (analog & (1 << bit)) {
+				if (analogValues[slot] != sentAnalogValues[slot]) {
+					mask |= 1 << bit;
+				}
+				slot++;
+			}
+		}
+	}
+	if ((group << 3) + 8 > Number_Of_Pins) {
+		mask &= (1 << (Number_Of_Pins & 7)) - 1;	// bits after the last pin are not pins
+	}
+	return mask;
+}
+/**
+ * @name buildInputList()
+ * Fills inputList with the input pins in the order of the pin table. The k-th input value of a test case goes to the
+ * k-th input pin, so activating a test case only walks this list. Called by _begin() and when pinMode() makes a pin
+ * an input or an output
+ */
+void AutoTestBase::buildInputList() {
+
+	numberOfInputs = 0;
+	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+		if (isInputPin(i)) {
+			inputList[numberOfInputs++] = i;
+		}
+	}
 }
 /**
  * @name activateTestcase()
  * Activates the current load testcase if there is one
  */
-void AutoTest::activateNextTestCase(){
+void AutoTestBase::activateNextTestCase(){
+	//
+	// streamed test cases come in while the sketch runs
+	//
+	if (testCaseStream != NULL) {
+		pollStream();
+		if (streamWaiting) {
+			getStreamTestCase();
+		}
+	}
 	//
 	// check if there are anymore testcases
 	//
@@ -706,35 +2412,382 @@ void AutoTest::activateNextTestCase(){
 		//
 		// now check if we can activate this Testcase
 		//
-		if (millis() > activateTestCase) {
+		if (clockMillis() > activateTestCase) {
 			//
-			// time to activate the testcase
-			// copy the test case description
+			// time to activate the testcase. The test case before gets its check now if it did not have it yet
 			//
-			strcpy(actionText, nextTestCaseDescription);
+			checkExpected(true);
+			activeTestCaseNumber = nextTestCaseNumber;
 			//
-			// copy the only the input pins
+			// copy the input values to the input pins. A pin that is still INPUT because the sketch did not set its
+			// mode yet can make the list longer than the test case, it keeps its value
 			//
-			uint8_t j = 0;
-			for (uint8_t i = 0; i < Number_Of_Pins; i++) {
-				if(pinMap[((i * 2) + 1)] == INPUT || pinMap[((i * 2) + 1)] == INPUT_PULLUP){
+			for (uint8_t j = 0; j < numberOfInputs && j < Number_Of_Input_Pins; j++) {
+				uint8_t i = inputList[j];		// pin index of this input
+
+				if (generators != NULL) {
 					//
-					// this is an input pin. If an analog read takes place this should still work fine
-					// als all pins are defined as INPUT
+					// a generator starts now. Its value at this moment is the input value
 					//
-					pinVal[i] = nextInputValues[j];
-					j++;
+					generators[i]		= nextGenerators[j];
+					generators[i].start	= clockMillis();
+					if (generators[i].type != AUTOTEST_GENERATOR_NONE) {
+						nextInputValues[j] = generatorValue(i);
+					}
+				}
+				if (setPinValue(i, nextInputValues[j])) {
+					traceEvent(AUTOTEST_EVENT_INPUT, i, getPinValue(i));
 				}
 			}
 			//
 			// and let the user know this test cases is activated
 			//
-			displayPins();
+			traceEvent(AUTOTEST_EVENT_ACTIVATE, 0, activeTestCaseNumber);
+			//
+			// from now on the first change of every output pin is a response to this test case
+			//
+			if (latency != NULL) {
+				activationTime = clockTime();
+				for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+					latency[i].waiting = true;
+				}
+			}
+			//
+			// the expected values are checked in the window after this moment
+			//
+			if (nextNumberOfExpected != 0) {
+				memcpy(expectedValues, nextExpectedValues, nextNumberOfExpected * sizeof(uint16_t));
+				numberOfExpected	= nextNumberOfExpected;
+				checkFrom			= clockMillis() + nextCheckFrom;
+				checkTo				= clockMillis() + nextCheckTo;
+				checkTestCase		= activeTestCaseNumber;
+				checkPending		= true;
+				strcpy(checkDescription, nextTestCaseDescription);
+			}
 			//
 			// set the next testcase ready
 			//
 			getTestCase();
+			sendResult();
+			//
+			// the next test case is loaded, so a handler that reads a pin does not activate this one again
+			//
+			checkInterrupts();
+		}
+	}
+	checkExpected(false);
+}
+/**
+ * @name checkInterrupts()
+ * Calls the handler of each input pin whose level changed since the last check in the way its mode asks for. LOW
+ * is taken as the pin going LOW, as the handler would otherwise be called for as long as the pin stays LOW
+ */
+void AutoTestBase::checkInterrupts() {
+
+	for (uint8_t i = 0; i < numberOfInterrupts; i++) {
+		AutoTestInterrupt	*interrupt = &interrupts[i];
+		bool				level = getPinValue(interrupt->pinIndex) != 0;
+
+		if (level == interrupt->level) {
+			continue;
+		}
+		interrupt->level = level;
+		if (interrupt->mode == CHANGE || (interrupt->mode == RISING && level) ||
+			((interrupt->mode == FALLING || interrupt->mode == LOW) && !level)) {
+			traceEvent(AUTOTEST_EVENT_INTERRUPT, interrupt->pinIndex, interrupt->mode);
+			interrupt->handler();
+		}
+	}
+}
+/**
+ * @name pinChanged(uint8_t pinIndex)
+ * @param pinIndex	pin index of the output pin that was written with a new value
+ * If this is the first change of the pin since the last test case was activated, the time since the activation is
+ * added to the statistics of the pin and sent as an AUTOTEST_EVENT_LATENCY
+ */
+void AutoTestBase::pinChanged(uint8_t pinIndex) {
+	AutoTestLatency	*pinLatency;			// statistics of this pin
+	unsigned long	time;					// usec since the activation
+	uint8_t			bucket = 0;				// histogram bucket for time
+
+	if (latency == NULL || !latency[pinIndex].waiting) {
+		return;
+	}
+	pinLatency			= &latency[pinIndex];
+	pinLatency->waiting	= false;
+	time				= clockTime() - activationTime;
+	if (pinLatency->responses == 0 || time < pinLatency->minimum) {
+		pinLatency->minimum = time;
+	}
+	if (pinLatency->responses == 0 || time > pinLatency->maximum) {
+		pinLatency->maximum = time;
+	}
+	pinLatency->total += time;
+	pinLatency->responses++;
+	//
+	// each bucket is 4 times as wide as the one before
+	//
+	for (unsigned long t = time >> 4; t != 0 && bucket < AUTOTEST_LATENCY_BUCKETS - 1; t >>= 2) {
+		bucket++;
+	}
+	pinLatency->histogram[bucket]++;
+	traceEvent(AUTOTEST_EVENT_LATENCY, pinIndex, time);
+}
+/**
+ * @name printLatencyStats()
+ * Sends a CSV table with the response times of each pin that responded to a test case:
+ * \n pin;responses;min;max;mean;then the number of responses < 16, 64, 256, 1024, 4096, 16384, 65536 usec and more
+ * \n Only if AUTOTEST_LATENCY_STATS is defined. The host build calls it at the end of the run, on the board the sketch
+ * can call it when testSetCompleted() becomes true
+ */
+void AutoTestBase::printLatencyStats() {
+
+	if (latency == NULL) {
+		return;
+	}
+	//
+	// the table can be larger than the trace buffer so the buffer is emptied and the table goes straight to Serial
+	//
+	while (flush()) {
+	}
+	Serial.println("");
+	Serial.print("latency pin;responses;min usec;max usec;mean usec;<16;<64;<256;<1024;<4096;<16384;<65536;more");
+	for (uint8_t i = 0; i < Number_Of_Pins; i++) {
+		if (latency[i].responses != 0) {
+			Serial.println("");
+			printPinName(&Serial, i);
+			Serial.print(CSV_SEPARATOR);
+			Serial.print(latency[i].responses);
+			Serial.print(CSV_SEPARATOR);
+			Serial.print(latency[i].minimum);
+			Serial.print(CSV_SEPARATOR);
+			Serial.print(latency[i].maximum);
+			Serial.print(CSV_SEPARATOR);
+			Serial.print(latency[i].total / latency[i].responses);
+			for (uint8_t j = 0; j < AUTOTEST_LATENCY_BUCKETS; j++) {
+				Serial.print(CSV_SEPARATOR);
+				Serial.print(latency[i].histogram[j]);
+			}
+		}
+	}
+	Serial.println("");
+}
+/**
+ * @name AutoTestTraceBuffer()
+ * Constructor. The buffer has no memory until setBuffer() is called
+ */
+AutoTestTraceBuffer::AutoTestTraceBuffer() {
+
+	buffer		= NULL;
+	size		= 0;
+	head		= 0;
+	tail		= 0;
+	recordEnd	= 0;
+	overflow	= false;
+}
+/**
+ * @name setBuffer(uint8_t *buffer, uint16_t size)
+ * @param buffer	memory for the ring
+ * @param size		number of bytes in buffer. One byte is kept free to tell a full ring from an empty one
+ */
+void AutoTestTraceBuffer::setBuffer(uint8_t *buffer, uint16_t size) {
+
+	this->buffer	= buffer;
+	this->size		= size;
+	head			= 0;
+	tail			= 0;
+	recordEnd		= 0;
+	overflow		= false;
+}
+/**
+ * @name write(uint8_t data)
+ * @param data	byte to add to the record being written
+ * @returns size_t	1 if the byte fits
+ */
+size_t AutoTestTraceBuffer::write(uint8_t data) {
+	uint16_t next = recordEnd + 1;		// where the byte after this one goes
+
+	if (next == size) {
+		next = 0;
+	}
+	if (overflow || next == tail) {
+		overflow = true;
+		return 0;
+	}
+	buffer[recordEnd]	= data;
+	recordEnd			= next;
+	return 1;
+}
+/**
+ * @name commit()
+ * @returns bool	false if the record did not fit. It is removed from the buffer
+ * Ends the record being written so drain() can send it
+ */
+bool AutoTestTraceBuffer::commit() {
+	bool fits = !overflow;				// true if the whole record is in the buffer
+
+	if (fits) {
+		head		= recordEnd;
+	} else {
+		recordEnd	= head;
+	}
+	overflow = false;
+	return fits;
+}
+/**
+ * @name drain(Print &port)
+ * @param port	where the records go (Serial)
+ * Sends committed bytes as long as port has room in its transmit buffer, so it never waits
+ */
+void AutoTestTraceBuffer::drain(Print &port) {
+	int room = port.availableForWrite();	// bytes port takes without waiting
+
+	while (room > 0 && tail != head) {
+		uint16_t end = tail < head ? head : size;	// the bytes up to head or the end of the ring
+		uint16_t length = end - tail;
+
+		if (length > (unsigned int)room) {
+			length = room;
+		}
+		port.write(&buffer[tail], length);
+		room -= length;
+		tail = tail + length == size ? 0 : tail + length;
+	}
+}
+/**
+ * @name empty()
+ * @returns bool	true if all committed records are sent
+ */
+bool AutoTestTraceBuffer::empty() {
+
+	return tail == head;
+}
+/**
+ * @name AutoTestCaptureBuffer()
+ * Constructor. The buffer has no memory until setBuffer() is called
+ */
+AutoTestCaptureBuffer::AutoTestCaptureBuffer() {
+
+	setBuffer(NULL, 0);
+}
+/**
+ * @name setBuffer(uint8_t *buffer, uint16_t size)
+ * @param buffer	memory for the ring
+ * @param size		number of bytes in buffer. One byte is kept free to tell a full ring from an empty one
+ */
+void AutoTestCaptureBuffer::setBuffer(uint8_t *buffer, uint16_t size) {
+
+	this->buffer	= buffer;
+	this->size		= size;
+	head			= 0;
+	tail			= 0;
+	recordEnd		= 0;
+	records			= 0;
+	droppedRecords	= 0L;
+	overflow		= false;
+}
+/**
+ * @name capacity()
+ * @returns uint16_t	number of bytes in the ring. 0 if it has no memory
+ */
+uint16_t AutoTestCaptureBuffer::capacity() {
+
+	return size;
+}
+/**
+ * @name write(uint8_t data)
+ * @param data	byte to add to the record being written
+ * @returns size_t	1 if the byte fits
+ * The first byte of a record is preceded by 2 bytes for its length. Old records make room for the new one
+ */
+size_t AutoTestCaptureBuffer::write(uint8_t data) {
+	uint8_t bytes[3] = { 0, 0, data };	// length of a new record and the byte
+	uint8_t	first = recordEnd == head ? 0 : 2;	// the length is written with the first byte
+
+	if (overflow) {
+		return 0;
+	}
+	for (uint8_t i = first; i < 3; i++) {
+		uint16_t next = recordEnd + 1 == size ? 0 : recordEnd + 1;	// where the byte after this one goes
+
+		while (next == tail) {
+			if (records == 0) {
+				//
+				// the record alone takes the whole ring
+				//
+				overflow = true;
+				return 0;
+			}
+			dropOldest();
 		}
+		buffer[recordEnd]	= bytes[i];
+		recordEnd			= next;
+	}
+	return 1;
+}
+/**
+ * @name commit(uint16_t keep)
+ * @param keep	number of records to keep, the one written last included
+ * Ends the record being written. A record without bytes is not kept
+ */
+void AutoTestCaptureBuffer::commit(uint16_t keep) {
+	uint16_t length = (recordEnd + size - head) % size - 2;	// bytes in the record without its length
+
+	if (overflow) {
+		recordEnd	= head;
+		overflow	= false;
+		droppedRecords++;
+	} else if (recordEnd != head) {
+		buffer[head]					= length;
+		buffer[(head + 1) % size]		= length >> 8;
+		head							= recordEnd;
+		records++;
+	}
+	while (records > keep) {
+		dropOldest();
+	}
+}
+/**
+ * @name sendRecord(Print &port)
+ * @param port	where the record goes
+ * @returns bool	false if the history is empty
+ */
+bool AutoTestCaptureBuffer::sendRecord(Print &port) {
+	uint16_t length;					// bytes in the record
+
+	if (records == 0) {
+		return false;
+	}
+	length	= buffer[tail] | (buffer[(tail + 1) % size] << 8);
+	tail	= (tail + 2) % size;
+	while (length > 0) {
+		uint16_t part = size - tail < length ? size - tail : length;	// the bytes up to the end of the ring
+
+		port.write(&buffer[tail], part);
+		length	-= part;
+		tail	= (tail + part) % size;
 	}
+	records--;
+	return true;
+}
+/**
+ * @name dropped()
+ * @returns unsigned long	number of records dropped since the last call
+ */
+unsigned long AutoTestCaptureBuffer::dropped() {
+	unsigned long count = droppedRecords;
+
+	droppedRecords = 0L;
+	return count;
+}
+/**
+ * @name dropOldest()
+ * Removes the oldest record to make room
+ */
+void AutoTestCaptureBuffer::dropOldest() {
+	uint16_t length = buffer[tail] | (buffer[(tail + 1) % size] << 8);	// bytes in the record
 
+	tail = (tail + 2 + length) % size;
+	records--;
+	droppedRecords++;
 }
@@ -32,16 +32,282 @@
 //
 #define CSV_SEPARATOR ";"
 //
+// On the host the time is virtual. delay() moves the clock forward without waiting and when the sketch is idle
+// the clock jumps to the moment the next test case gets activated. AUTOTEST_IDLE_STEP is the time in usec the clock
+// moves forward when the sketch was only polling the clock. Every look at the clock costs AUTOTEST_CLOCK_TICK usec.
+//
+#ifdef AUTOTEST_HOST
+#define AUTOTEST_VIRTUAL_CLOCK
+#endif
+#ifndef AUTOTEST_IDLE_STEP
+#define AUTOTEST_IDLE_STEP		1000UL
+#endif
+#ifndef AUTOTEST_CLOCK_TICK
+#define AUTOTEST_CLOCK_TICK		1UL
+#endif
+//
+// Lookup of the pin index for a pin number. By default a 256 byte table is used that gives the index directly.
+// Define AUTOTEST_COMPACT_PIN_LOOKUP to use a bitset with a rank table instead (64 bytes + 1 byte per pin) when RAM is
+// tight. This is the default on boards with 2K RAM or less (ATmega328 etc). AUTOTEST_LINEAR_PIN_LOOKUP searches
+// pinNumbers like before and is only there to compare against.
+//
+#if defined(RAMEND) && RAMEND <= 0x8FF && !defined(AUTOTEST_LINEAR_PIN_LOOKUP) && !defined(AUTOTEST_FULL_PIN_LOOKUP)
+#define AUTOTEST_COMPACT_PIN_LOOKUP
+#endif
+//
+// Packed test cases (AUTOTEST_PACKED_TEST_CASES in AutomaticTesting.h) have a fixed record size in words. The
+// delay (2 words) and the description offset (1 word) come before the input values
+//
+#define AUTOTEST_PACKED_RECORD_WORDS(inputPins)	(3 + (inputPins))
+//
+// bytes of a table with a bit per pin
+//
+#define AUTOTEST_PIN_BITS(pins)		(((pins) + 7) / 8)
+//
+// Streamed test cases (AUTOTEST_STREAM_TEST_CASES in AutomaticTesting.h) come in over Serial. Two record buffers are
+// filled while the sketch runs and AutoTest sends AUTOTEST_STREAM_REQUEST each time one of them is free. In binary and
+// delta mode any byte can be data, so a data byte that is AUTOTEST_STREAM_REQUEST or AUTOTEST_STREAM_ESCAPE is sent
+// as AUTOTEST_STREAM_ESCAPE followed by the byte xor 0x20. The feeder undoes this, so a bare request byte is always a
+// request, even in the middle of a record. A record
+// has room for a description, an input field per input pin, 4 digits per expected value, a delay and check window of
+// 9 digits and the separators
+//
+#define AUTOTEST_STREAM_RECORD_LENGTH(pins, inputPins)	(26 + (inputPins) * AUTOTEST_INPUT_FIELD + ((pins) - (inputPins)) * 5 + 30 + 1)
+#define AUTOTEST_STREAM_REQUEST		0x11		// XON. asks the feeder for the next record
+#define AUTOTEST_STREAM_ESCAPE		0x10		// DLE. the next byte is a data byte xor 0x20
+#ifdef AUTOTEST_STREAM_TEST_CASES
+#define AUTOTEST_STREAM_BUFFERS		2
+#else
+#define AUTOTEST_STREAM_BUFFERS		0
+#endif
+#ifndef AUTOTEST_STREAM_TIMEOUT
+#define AUTOTEST_STREAM_TIMEOUT		10000UL		// msec the host build waits for a record before the test set ends
+#endif
+//
+// output modes (setOutputMode())
+//
+#define AUTOTEST_OUTPUT_CSV		0				// a line of text with all pin values per event
+#define AUTOTEST_OUTPUT_BINARY	1				// a fixed size frame per event, see sendFrame()
+#define AUTOTEST_OUTPUT_DELTA	2				// only the pins that changed per event, see sendDelta()
+#define AUTOTEST_OUTPUT_VERDICT	3				// only the results of the expected values in the test cases
+//
+// events sent to the output. In binary mode this is the type byte of the frame
+//
+#define AUTOTEST_EVENT_READ					1	// digitalRead() or analogRead()
+#define AUTOTEST_EVENT_WRITE				2	// digitalWrite()
+#define AUTOTEST_EVENT_ANALOG_WRITE			3	// analogWrite()
+#define AUTOTEST_EVENT_INPUT				4	// input pin changed by a test case
+#define AUTOTEST_EVENT_ACTIVATE				5	// test case activated. comes after its AUTOTEST_EVENT_INPUTs
+#define AUTOTEST_EVENT_PIN_MODE				6	// pinMode()
+#define AUTOTEST_EVENT_INVALID_PIN_MODE		7	// pinMode() on a pin not in the test set
+#define AUTOTEST_EVENT_INVALID_READ			8	// digitalRead() on a pin not in the test set
+#define AUTOTEST_EVENT_INVALID_ANALOG_READ	9	// analogRead() on a pin not in the test set
+#define AUTOTEST_EVENT_INVALID_WRITE		10	// digitalWrite() on a pin not in the test set
+#define AUTOTEST_EVENT_INVALID_ANALOG_WRITE	11	// analogWrite() on a pin not in the test set
+#define AUTOTEST_EVENT_INVALID_VALUE		12	// digitalWrite() with a value other than HIGH or LOW
+#define AUTOTEST_EVENT_DROPPED				13	// the trace buffer was full. value is the number of records lost
+#define AUTOTEST_EVENT_LATENCY				14	// first change of an output pin after a test case. value in usec
+#define AUTOTEST_EVENT_READ_REPEAT			15	// the read before was repeated value times (coalesceReads())
+#define AUTOTEST_EVENT_PASS					16	// test case number value had the expected output values
+#define AUTOTEST_EVENT_FAIL					17	// test case number value did not have the expected output values
+#define AUTOTEST_EVENT_MISMATCH				18	// after AUTOTEST_EVENT_FAIL: output pin. value is expected << 16 | actual
+#define AUTOTEST_EVENT_RESULT				19	// all test cases checked. value is the number that failed
+#define AUTOTEST_EVENT_ANALOG_FULL			20	// value other than 0 or 1 with all AUTOTEST_ANALOG_PINS in use. The pin is set HIGH
+#define AUTOTEST_EVENT_PORT_WRITE			21	// PORTx or PINx written. pin is the port (PB etc), value what the port holds now
+#define AUTOTEST_EVENT_PORT_READ			22	// PINx read. pin is the port, value the bits read
+#define AUTOTEST_EVENT_PORT_PIN				23	// output pin changed by a port write. comes before its AUTOTEST_EVENT_PORT_WRITE
+#define AUTOTEST_EVENT_INTERRUPT			24	// the handler of the input pin is called. value is the mode
+#define AUTOTEST_EVENT_INVALID_INTERRUPT	25	// attachInterrupt() on a pin not in the test set or no room. pin is the interrupt
+#define AUTOTEST_EVENT_TRIGGER				26	// the trigger fired (captureOnTrigger()). value is the number of events not sent before the history
+
+#define AUTOTEST_DONT_CARE		0xFFFF			// expected value of an output pin that is not checked
+
+#define AUTOTEST_FRAME_SYNC		0xA5			// first byte of each binary frame
+#define AUTOTEST_FRAME_LENGTH	12				// size of a binary frame
+#define AUTOTEST_DELTA_SYNC		0x5A			// first byte of a delta record
+#define AUTOTEST_KEYFRAME_SYNC	0x5B			// first byte of a delta record with all the pins
+#ifndef AUTOTEST_KEYFRAME_INTERVAL
+#define AUTOTEST_KEYFRAME_INTERVAL	32			// default number of delta records between keyframes
+#endif
+//
+// Size in bytes of the trace buffer. With a buffer the records are not written to Serial while the sketch waits but
+// put in the buffer and sent from yield(), delay() or autotest.flush(). Define it in the sketch before including
+// AutomaticTesting.h. 0 writes straight to Serial like before
+//
+#ifndef AUTOTEST_TRACE_BUFFER
+#define AUTOTEST_TRACE_BUFFER	0
+#endif
+//
+// Size in bytes of the history kept by captureOnTrigger(). Until the trigger fires the records go into this ring
+// instead of to Serial and the oldest ones are dropped. Define it in the sketch before including AutomaticTesting.h.
+// 0 leaves captureOnTrigger() without effect
+//
+#ifndef AUTOTEST_CAPTURE_BUFFER
+#define AUTOTEST_CAPTURE_BUFFER	0
+#endif
+//
+// Define AUTOTEST_LATENCY_STATS as 1 in the sketch before including AutomaticTesting.h to measure the time from the
+// activation of a test case to the first change of each output pin. See printLatencyStats()
+//
+#ifndef AUTOTEST_LATENCY_STATS
+#define AUTOTEST_LATENCY_STATS	0
+#endif
+//
+// Pin values are kept as a bit per pin. A pin gets 16 bits only once it has a value other than 0 or 1 (analogRead(),
+// analogWrite() or an analog input value). The number of pins that can have such a value is NUMBER_OF_ANALOG_PINS
+// from FieldLengths.h, which generateTestSet counts from the test set. Define AUTOTEST_ANALOG_PINS in the sketch
+// before including AutomaticTesting.h to allow fewer
+//
+#ifndef AUTOTEST_ANALOG_PINS
+#define AUTOTEST_ANALOG_PINS	255
+#endif
+#define AUTOTEST_ANALOG_SLOTS(pins)	(AUTOTEST_ANALOG_PINS < (pins) ? AUTOTEST_ANALOG_PINS : (pins))
+#define AUTOTEST_LATENCY_BUCKETS	8			// histogram buckets: < 16, 64, 256, 1024, 4096, 16384, 65536 usec and more
+//
+// Define AUTOTEST_ANALOG_GENERATORS as 1 in the sketch before including AutomaticTesting.h to let a test case drive
+// an input pin with a generator instead of a fixed value. The input field is a letter followed by 3 numbers
+// separated by ':' (r0:1023:2000 for example). The value is computed at each read from the msec since activation:
+// \n r from:to:msec			ramp from from to to in msec, then stays at to
+// \n s middle:amplitude:msec	sine around middle with a period of msec
+// \n q low:high:msec			square wave, low for the first half of each period of msec, then high
+// \n t from:to:msec			step from from to to after msec
+// \n n middle:amplitude:seed	noise from middle - amplitude to middle + amplitude, a new value each msec
+//
+#ifndef AUTOTEST_ANALOG_GENERATORS
+#define AUTOTEST_ANALOG_GENERATORS	0
+#endif
+#define AUTOTEST_GENERATOR_NONE		0			// the pin has the value of the test case
+#define AUTOTEST_GENERATOR_RAMP		'r'
+#define AUTOTEST_GENERATOR_SINE		's'
+#define AUTOTEST_GENERATOR_SQUARE	'q'
+#define AUTOTEST_GENERATOR_STEP		't'
+#define AUTOTEST_GENERATOR_NOISE	'n'
+#define AUTOTEST_INPUT_FIELD		19			// longest input field with its separator (s65535:65535:65535,)
+
+//
+// Define AUTOTEST_PORTS in the sketch before including AutomaticTesting.h to reroute the port registers of an AVR
+// (PORTB, PINB, DDRB etc) to AutoTest as well. A register is then an AutoTestPort that maps its bits to the pins of
+// the test set with digitalPinToPort() and digitalPinToBitMask(). A write of several pins is one event
+//
+#if defined(__AVR__) || defined(AUTOTEST_HOST)
+#define AUTOTEST_HAS_PORTS
+#endif
+#define AUTOTEST_REGISTER_PORT		0			// PORTx: the outputs
+#define AUTOTEST_REGISTER_PIN		1			// PINx: reads the pins, a write toggles the outputs
+#define AUTOTEST_REGISTER_DDR		2			// DDRx: bit set for an output
+
+//
+// Number of handlers attachInterrupt() can register (2 on an UNO, define it as 6 for a Mega). When a test case
+// changes an input pin with a handler, the handler is called right after the activation
+//
+#ifndef AUTOTEST_INTERRUPTS
+#define AUTOTEST_INTERRUPTS		2
+#endif
+
+//
+// blocks of memory saved by saveState() on the host: AutoTest itself, the tables of AutoTestHost and the variables the
+// sketch registers with registerState()
+//
+#ifndef AUTOTEST_STATE_BLOCKS
+#define AUTOTEST_STATE_BLOCKS	32
+#endif
+
 /**
- * @class AutoTest
+ * handler attached to an input pin with attachInterrupt()
+ */
+struct AutoTestInterrupt {
+	void			(*handler)();						// the interrupt service routine of the sketch
+	uint8_t			pinIndex;							// pin index of the interrupt pin
+	uint8_t			mode;								// LOW, CHANGE, RISING or FALLING
+	bool			level;								// the pin was HIGH at the last check
+};
+
+/**
+ * generator driving an input pin (AUTOTEST_ANALOG_GENERATORS)
+ */
+struct AutoTestGenerator {
+	uint8_t			type;								// AUTOTEST_GENERATOR_NONE, _RAMP, _SINE, _SQUARE, _STEP or _NOISE
+	uint16_t		parameter[3];						// the 3 numbers of the input field
+	unsigned long	start;								// msec at which the test case was activated
+};
+
+/**
+ * latency of one output pin over all the test cases
+ */
+struct AutoTestLatency {
+	unsigned int	responses;							// number of test cases the pin responded to
+	unsigned long	minimum;							// shortest time in usec
+	unsigned long	maximum;							// longest time in usec
+	unsigned long	total;								// sum of all the times, for the mean
+	unsigned int	histogram[AUTOTEST_LATENCY_BUCKETS];	// number of responses per bucket
+	bool			waiting;							// the pin did not change since the last activation
+};
+
+/**
+ * @class AutoTestTraceBuffer
+ * Ring buffer between AutoTest and Serial. AutoTest writes a record and commits it. A record that does not fit is
+ * dropped as a whole so the stream never contains half a record. drain() sends as much as Serial takes without
+ * waiting. Only AutoTest moves head and only drain() moves tail so no locking is needed.
+ */
+class AutoTestTraceBuffer : public Print {
+public:
+	AutoTestTraceBuffer();
+	void	setBuffer(uint8_t *buffer, uint16_t size);	// memory to use for the ring
+	virtual size_t write(uint8_t data);					// adds a byte to the record being written
+	using	Print::write;
+	bool	commit();									// ends the record. false if it did not fit and was dropped
+	void	drain(Print &port);							// sends what port takes without waiting
+	bool	empty();									// true if all committed records are sent
+
+private:
+	uint8_t				*buffer;						// the ring
+	uint16_t			size;							// bytes in the ring
+	volatile uint16_t	head;							// end of the committed records
+	volatile uint16_t	tail;							// next byte to send
+	uint16_t			recordEnd;						// end of the record being written
+	bool				overflow;						// the record being written did not fit
+};
+
+/**
+ * @class AutoTestCaptureBuffer
+ * History of the last records before a trigger. Each record is kept with its length in front of it. When a new record
+ * does not fit, or there are more records than asked for, the oldest records are dropped, so the history always
+ * ends with the record written last. A record larger than the whole buffer is lost.
+ */
+class AutoTestCaptureBuffer : public Print {
+public:
+	AutoTestCaptureBuffer();
+	void	setBuffer(uint8_t *buffer, uint16_t size);	// memory to use for the ring
+	uint16_t capacity();								// bytes in the ring. 0 without memory
+	virtual size_t write(uint8_t data);					// adds a byte to the record being written
+	using	Print::write;
+	void	commit(uint16_t keep);						// ends the record and keeps only the last keep records
+	bool	sendRecord(Print &port);					// sends the oldest record. false if there is none
+	unsigned long dropped();							// records dropped since the history was sent last
+
+private:
+	void	dropOldest();								// removes the oldest record
+	uint8_t				*buffer;						// the ring
+	uint16_t			size;							// bytes in the ring
+	uint16_t			head;							// end of the committed records
+	uint16_t			tail;							// start of the oldest record, its length
+	uint16_t			recordEnd;						// end of the record being written
+	uint16_t			records;						// committed records in the ring
+	unsigned long		droppedRecords;					// committed records dropped since the last send
+	bool				overflow;						// the record being written is larger than the ring
+};
+
+/**
+ * @class AutoTestBase
  * Class for handling autotest facility into Arduino programs. It captures all the digitalRead and digitalWrite functions
  * insode the program where it is included and repleces these functions by allowing test input to be put into read operations
  * and outputs all Write + read pins to the Serial
+ *
+ * The tables are not part of this class. They are members of the AutoTest template below which is sized with the
+ * defines from FieldLengths.h, so no memory is allocated at runtime.
  */
-class AutoTest {
+class AutoTestBase {
 public:
-	AutoTest(uint8_t, uint8_t, uint8_t, uint8_t, PGM_P, PGM_P);
-
 	void begin(void (*)());								// initialize the auto test with an extend display pins function
 	void begin();										// initializes the AutoTest with no extend display function
 	uint8_t  callDigitalRead(uint8_t pin);					// replacement function for digitalRead()
@@ -50,12 +316,51 @@ public:
 	void callAnalogWrite(uint8_t pin, uint8_t val);		// replacement function for analogWrite()
 	void callPinMode(uint8_t pin, uint8_t mode);		// replacement function for pinMode()
 	void doNotDisplayReadsIf(uint8_t val);				// omits displaying pin info if pin in Read has value x
+	void coalesceReads(bool on);						// counts repeated reads instead of displaying each of them
+	void sendPendingReads();							// sends the count of repeated reads that is not sent yet
+	void finish();										// ends the run: sends what is pending and the result
+	unsigned int failedTestCases();						// number of test cases without the expected values
+	bool testSetCompleted();							// true when the last test case has been activated
+	unsigned long callMillis();							// replacement function for millis()
+	unsigned long callMicros();							// replacement function for micros()
+	void callDelay(unsigned long ms);					// replacement function for delay()
+	void callDelayMicroseconds(unsigned int us);		// replacement function for delayMicroseconds()
+	void idle();										// called after each loop(). moves the virtual clock if nothing happened
+	void setOutputMode(uint8_t mode);					// AUTOTEST_OUTPUT_CSV, _BINARY or _DELTA
+	void setKeyframeInterval(uint8_t records);			// number of delta records between two keyframes
+	bool flush();										// sends buffered trace records Serial can take now
+	unsigned long droppedRecords();						// number of records lost because the trace buffer was full
+	void printLatencyStats();							// sends the response times per output pin to Serial
+	void captureOnTrigger(uint16_t before, uint16_t after);	// only sends the events around a trigger
+	void triggerOnPin(uint8_t pin, uint16_t value);		// triggers when the pin gets value
+	void triggerOnTestCase(int testCase);				// triggers when the test case is activated
+	void triggerOn(bool (*condition)());				// triggers when the function returns true
+	void registerState(void *block, size_t size);		// variables of the sketch that are part of a checkpoint
+#ifdef AUTOTEST_HOST
+	void startPackedTestCases(const uint16_t *records, PGM_P descriptions, unsigned int count);	// runs other test cases (fuzzing)
+	size_t stateSize();									// bytes saveState() writes
+	uint8_t stateBlockCount();							// number of blocks registered for the checkpoints
+	void saveState(uint8_t *state);						// saves a checkpoint of AutoTest and the registered variables
+	bool restoreState(const uint8_t *state);			// goes back to a checkpoint
+	int pendingTestCase();								// number of the test case activated next. 10000 if none
+	void continueTestCases(PGM_P records);				// the test cases after the pending one come from records
+#endif
+	void callAttachInterrupt(uint8_t interrupt, void (*handler)(), int mode);	// replacement function for attachInterrupt()
+	void callDetachInterrupt(uint8_t interrupt);		// replacement function for detachInterrupt()
+#ifdef AUTOTEST_HAS_PORTS
+	uint8_t callPortRead(uint8_t port, uint8_t reg);	// replacement for reading PORTx, PINx or DDRx
+	void callPortWrite(uint8_t port, uint8_t reg, uint8_t value);	// replacement for writing PORTx, PINx or DDRx
+#endif
 
-private:
+protected:
+	AutoTestBase(uint8_t, uint8_t, uint8_t, uint8_t, PGM_P, PGM_P);
+	AutoTestBase(uint8_t, uint8_t, uint8_t, uint8_t, PGM_P, const uint16_t *, PGM_P, unsigned int);	// packed test cases
+	AutoTestBase(uint8_t, uint8_t, uint8_t, uint8_t, PGM_P, Stream *);	// streamed test cases
 	//
 	// variables used for activating a new test case
 	//
 	int				nextTestCaseNumber;					// number of next test case
+	int				activeTestCaseNumber;				// number of the test case activated last. -1 if none
 	uint16_t		* nextInputValues;					// array containing the input values for the next test case.
 	unsigned long 	activationDelay;					// delay before the next test case is activated
 	unsigned long 	activateTestCase;					// moment when to activate the test case
@@ -63,44 +368,342 @@ private:
 	PGM_P			pinHeaders;							// pointer ot PinHeaders in Flash
 	PGM_P			testCases;							// pointer to testCases in Flash
 	char			nextTestCaseDescription[26];		// description of next test case
+	const uint16_t	*packedTestCases;					// pointer to packed test case records in Flash. NULL if CSV
+	PGM_P			testCaseDescriptions;				// pointer to the descriptions of packed test cases in Flash
+	unsigned int	numberOfPackedTestCases;			// number of packed test case records
+	PGM_P			nextDescriptionPtr;					// description of the next packed test case in Flash
+	Stream			*testCaseStream;					// where streamed test cases come from. NULL if in Flash
+	char			*streamBuffer;						// AUTOTEST_STREAM_BUFFERS records of streamRecordLength
+	uint16_t		streamRecordLength;					// size of a record buffer including the '\0'
+	uint16_t		streamFill;							// bytes in the record buffer being filled
+	uint8_t			streamWrite;						// record buffer being filled
+	uint8_t			streamRead;							// record buffer with the next test case
+	bool			streamReady[2];						// the record buffer holds a complete record
+	bool			streamWaiting;						// the next test case did not arrive yet
 	uint8_t			Number_Of_Pins;						// number of pins filled in constructor
 	uint8_t			Max_Field_Length;					// field length filled in constructor
 	uint8_t			Number_Of_Input_Pins;				// number of input pins filled in constructor
 	uint8_t			Max_Description_Length;				// max length description filled in constructor
 	uint8_t			omitDisplayIf;						// contains value when to omit displaypins with read operations. if 99 all values are displayed
+	bool			coalesce;							// repeated reads are counted (coalesceReads())
+	uint8_t			readRunPin;							// pin index of the read that may repeat. 255 if none
+	uint16_t		readRunValue;						// value of that read
+	unsigned long	repeatedReads;						// number of times it was repeated since it was sent
+	unsigned long	readRunStart;						// time of the read that was sent
+	unsigned long	lastReadTime;						// time of the last repeated read
+	unsigned long	eventTime;							// time stamp of the event being traced
+	uint8_t			outputMode;							// AUTOTEST_OUTPUT_CSV, _BINARY or _DELTA
+	uint8_t			keyframeInterval;					// delta records between keyframes
+	uint8_t			recordsToKeyframe;					// delta records left before the next keyframe
+	uint8_t			recordCheck;						// xor of the bytes of the delta record being sent
+	unsigned long	lastRecordTime;						// time stamp of the last delta record
+	Print			*output;							// Serial or traceBuffer
+	AutoTestTraceBuffer traceBuffer;					// records waiting for Serial (AUTOTEST_TRACE_BUFFER)
+	uint16_t		pendingDropped;						// records dropped since the last AUTOTEST_EVENT_DROPPED
+	unsigned long	droppedTotal;						// records dropped since begin()
+	//
+	// triggered capture (captureOnTrigger()). While no trigger window is open the events go to captureBuffer
+	//
+	AutoTestCaptureBuffer captureBuffer;				// history before the trigger (AUTOTEST_CAPTURE_BUFFER)
+	bool			captureArmed;						// only the events around a trigger are sent
+	uint16_t		captureBefore;						// records kept in the history
+	uint16_t		captureAfter;						// records sent after the trigger
+	uint16_t		captureLeft;						// records still to send in the window. 0 while waiting
+	uint8_t			triggerPinIndex;					// pin of triggerOnPin(). 255 if none
+	uint16_t		triggerValue;						// and its value
+	int				triggerTestCase;					// test case of triggerOnTestCase(). -1 if none
+	bool			(*triggerCondition)();				// function of triggerOn(). NULL if none
+	bool			triggerLevel;						// the trigger condition held at the last event
+	AutoTestLatency	*latency;							// one per pin (AUTOTEST_LATENCY_STATS). NULL if not measured
+	AutoTestGenerator *nextGenerators;					// one per input value of the next test case. NULL if not used
+	AutoTestGenerator *generators;						// one per pin (AUTOTEST_ANALOG_GENERATORS)
+	AutoTestInterrupt *interrupts;						// attached handlers in the order of the pin table
+	uint8_t			numberOfInterrupts;					// entries in interrupts
+	uint8_t			maxInterrupts;						// room in interrupts (AUTOTEST_INTERRUPTS)
+	//
+	// expected output values. A test case record can end with check from,check to,expected values (see getTestCase())
+	//
+	uint16_t		*nextExpectedValues;				// expected values of the next test case, one per output pin
+	uint16_t		*expectedValues;					// expected values of the test case being checked
+	uint8_t			maxExpected;						// room in nextExpectedValues and expectedValues
+	uint8_t			nextNumberOfExpected;				// number of expected values of the next test case
+	uint8_t			numberOfExpected;					// number of expected values being checked
+	unsigned long	nextCheckFrom;						// msec after activation the check window opens
+	unsigned long	nextCheckTo;						// msec after activation the check window closes
+	unsigned long	checkFrom;							// the check window of the test case being checked
+	unsigned long	checkTo;
+	bool			checkPending;						// a test case waits for its check
+	bool			resultSent;							// AUTOTEST_EVENT_RESULT is sent
+	int				checkTestCase;						// number of the test case being checked
+	char			checkDescription[26];				// and its description
+	unsigned int	testsPassed;						// number of test cases checked with the expected values
+	unsigned int	testsFailed;						// number of test cases checked without them
+	unsigned long	activationTime;						// usec at which the active test case was activated
 	//
 	// other variables used
 	//
 	void 			(*callExtendDisplayPins)();			// function pointer to extend display pins
-	char			actionText[26];						// Action test to display with output (max 25 positions)
+#ifdef AUTOTEST_VIRTUAL_CLOCK
+	unsigned long	clockMicros;						// virtual time in usec
+	bool			clockQueried;						// the sketch looked at the clock since the last idle()
+	bool			clockDelayed;						// the sketch called delay() since the last idle()
+#endif
+	//
+	// Arrays created to the number of pins defined in the excel sheet. The memory is part of AutoTest<>
+	// A pin index is the position of the pin in pinHeaders.h and selects the entry in each of them
+	//
+	uint8_t 		*pinNumbers;		// real pin number of each pin
+	uint8_t			*inputPinBits;		// bit per pin, set if its mode is INPUT or INPUT_PULLUP
+	//
+	// the input values of a test case go to the input pins in order. The list only changes with a pinMode()
 	//
-	// Array created to the number of pins defined in the excel sheet. Memory is allocated during the construction
-	// pinMap has 2 columns:
-	// column 0 reference to real pin number
-	// column 1 mode (INPUT, OUTPUT, INPUT_PULLUP)
+	uint8_t			*inputList;			// pin index of each input pin
+	uint8_t			numberOfInputs;		// entries in inputList
 	//
-	uint8_t 		*pinMap;			// maps the pins
+	// pin number to pin index lookup, filled by _begin()
 	//
-	// pinVal corresponds to pinMap and contains the values. The reason to do it this way
-	// is to allow analog values for the pin which can have a value from 0-1023
+#if defined(AUTOTEST_COMPACT_PIN_LOOKUP)
+	uint8_t			pinBits[32];		// bit set for each pin in the test set
+	uint8_t			pinRank[32];		// number of bits set in pinBits before this byte
+	uint8_t			*rankToIndex;		// maps the rank of a pin (order of pin numbers) to the pin index
+#elif !defined(AUTOTEST_LINEAR_PIN_LOOKUP)
+	uint8_t			pinIndexTable[256];	// pin index for every pin number. Number_Of_Pins if not used
+#endif
 	//
-	uint16_t		*pinVal;			// maps to digital or analog values
+	// the values of the pins. A digital pin has a bit in digitalBits. Once a pin gets a value other than 0 or 1 (0-1023
+	// for analogRead()) its bit in analogPinBits is set and the value is in analogValues. The analog pins are kept in
+	// the order of the pin table, so the slot of a pin is the number of analog pins before it (see analogSlot())
+	//
+	uint8_t			*digitalBits;		// value of each digital pin
+	uint8_t			*sentDigitalBits;	// digitalBits as sent in the last delta record
+	uint8_t			*analogPinBits;		// bit per pin, set if its value is in analogValues
+	uint16_t		*analogValues;		// value of each analog pin
+	uint16_t		*sentAnalogValues;	// analogValues as sent in the last delta record
+	uint8_t			numberOfAnalog;		// slots of analogValues in use
+	uint8_t			maxAnalog;			// slots of analogValues
 
 	//
-	// pinDescriptions contains an array with the names of each pin. Memory is allocated during the construction
+	// the names of the pins stay in pinHeaders in Flash. pinNames has the offset of each name, which ends with '\n'.
+	// The memory is part of AutoTest<>
+	//
+	uint16_t		*pinNames;
+#ifdef AUTOTEST_HOST
+	//
+	// memory that makes up a checkpoint. The first block is the AutoTest object itself, this list included
 	//
-	char 			*pinDescriptions;
+	void			*stateBlocks[AUTOTEST_STATE_BLOCKS];
+	size_t			stateBlockSizes[AUTOTEST_STATE_BLOCKS];
+	uint8_t			numberOfStateBlocks;
+#endif
+
+private:
 	//
 	// methods
 	//
 	void 	_begin();									// does the actual initialization
 	void 	displayPins();								// outputs the pin values etc to Serial
+	void	printPinName(Print *port, uint8_t pinIndex);	// prints the name of the pin from Flash
+	void	traceEvent(uint8_t type, uint8_t pin, unsigned long value);	// sends an event to Serial in the output mode
+	void	writeEvent(uint8_t type, uint8_t pin, unsigned long value);	// writes an event to output in the output mode
+	void	pinChanged(uint8_t pinIndex);				// measures the latency if the pin waits for its first change
+	void	traceRead(uint8_t pinIndex, uint16_t value);	// sends a read unless it repeats the read before
+	void	captureEvent(uint8_t type, uint8_t pin, unsigned long value);	// adds an event to the history before the trigger
+	bool	checkTrigger();								// true if the trigger condition became true
+	void	checkExpected(bool final);					// compares the output pins with the expected values
+	void	sendResult();								// sends AUTOTEST_EVENT_RESULT once all checks are done
+	PGM_P	getField(PGM_P sourcePtr, char *destPtr, uint8_t size);	// copies a field of a test case record
+	bool	commitRecord();								// ends a record in the trace buffer. false if dropped
+	void	sendFrame(uint8_t type, uint8_t pin, unsigned long value);	// sends an event as a binary frame
+	void	sendDelta(uint8_t type, uint8_t pin, unsigned long value);	// sends an event with the pins that changed
+	void	putByte(uint8_t);							// sends a byte of a delta record
+	void	putNumber(unsigned long);					// sends a number of a delta record in 7 bit groups
+	void	writeBinary(uint8_t);						// writes a byte of a frame or delta record, escaped if streamed
+	unsigned long clockMillis();						// current time in msec without advancing the virtual clock
+	unsigned long clockTime();							// current time in usec without advancing the virtual clock
 	uint8_t getTestCase();								// points to the next testcase and checks if we are through
+	uint8_t getPackedTestCase();						// loads the next testcase from the packed records
+	uint8_t getStreamTestCase();						// loads the next testcase from the stream
+	void	pollStream();								// moves received bytes into the free record buffer
+	void	requestStreamRecord();						// asks the feeder for one more record
+	void	setInputValue(uint8_t input, const char *field);	// a value or generator of the next test case
+	uint16_t generatorValue(uint8_t pinIndex);			// value of the pin at this moment
 	int 	getRecordLength(PGM_P);						// gets the length of a record from Flash
-	uint8_t getPinIndex(uint8_t);						// searches pin Array and returns index for pin
+	uint8_t getPinIndex(uint8_t);						// returns the pin index of pin
+	void	buildPinIndex();							// fills the pin number to index lookup
+	bool	isInputPin(uint8_t pinIndex);				// true if the mode of the pin is INPUT or INPUT_PULLUP
+	uint8_t	portBit(uint8_t pinIndex, uint8_t port);	// bit of the pin in the port registers. 0 if on another port
+	uint16_t getPinValue(uint8_t pinIndex);				// value of the pin
+	bool	setPinValue(uint8_t pinIndex, uint16_t value);	// sets the value of the pin. true if it changed
+	uint8_t	analogSlot(uint8_t pinIndex);				// index in analogValues of the pin
+	uint8_t	changedPins(uint8_t group);					// bit per pin of the group of 8 that changed since the last delta
+	void	buildInputList();							// fills inputList from inputPinBits
 	PGM_P 	getToken(PGM_P sourcePtr, char * destPtr, uint8_t token); // copies a string up to a token
 	void	activateNextTestCase();						// activates the loaded testcase
+	void	checkInterrupts();							// calls the handlers of the input pins that had their edge
+	void	advanceClock(unsigned long us);				// moves the virtual clock, activating test cases on the way
+
+};
+
+/**
+ * @class AutoTest
+ * AutoTest object with all the tables sized at compile time. AutomaticTesting.h creates it with the defines from
+ * FieldLengths.h:
+ * \n AutoTest<NUMBER_OF_PINS, NUMBER_OF_INPUT_PINS, MAX_FIELD_LENGTH, MAX_DESCRIPTION_LENGTH, MAX_EXPECTED_VALUES,
+ * 			NUMBER_OF_ANALOG_PINS> autotest(pinHeaders, testCases);
+ * The RAM used is known at link time and the heap is not used. EXPECTED_VALUES is the largest number of expected
+ * values in a test case, so a test set without checks does not pay for them. ANALOG_PINS is the number of pins that
+ * get a 16 bit value slot, NUMBER_OF_ANALOG_PINS in FieldLengths.h.
+ */
+template <uint8_t PINS, uint8_t INPUT_PINS, uint8_t FIELD_LENGTH, uint8_t DESCRIPTION_LENGTH, uint8_t EXPECTED_VALUES = PINS,
+		  uint8_t ANALOG_PINS = PINS>
+class AutoTest : public AutoTestBase {
+public:
+	/**
+	 * @name AutoTest(PGM_P pointerPinHeaders, PGM_P pointerTestCases)
+	 * @param pointerPinHeaders  	address of pinHeaders file in FLASH memory
+	 * @param pointerTestCases 		address of testCases file in FLASH memory
+	 */
+	AutoTest(PGM_P pointerPinHeaders, PGM_P pointerTestCases)
+		: AutoTestBase(PINS, INPUT_PINS, FIELD_LENGTH, DESCRIPTION_LENGTH, pointerPinHeaders, pointerTestCases) {
+		useTables();
+	}
+	/**
+	 * @name AutoTest(PGM_P pointerPinHeaders, const uint16_t *pointerTestCases, PGM_P pointerDescriptions, unsigned int numberOfTestCases)
+	 * @param pointerPinHeaders  	address of pinHeaders file in FLASH memory
+	 * @param pointerTestCases 		address of the packed test case records in FLASH memory
+	 * @param pointerDescriptions 	address of the test case descriptions in FLASH memory
+	 * @param numberOfTestCases		number of records in pointerTestCases
+	 */
+	AutoTest(PGM_P pointerPinHeaders, const uint16_t *pointerTestCases, PGM_P pointerDescriptions, unsigned int numberOfTestCases)
+		: AutoTestBase(PINS, INPUT_PINS, FIELD_LENGTH, DESCRIPTION_LENGTH, pointerPinHeaders, pointerTestCases,
+					   pointerDescriptions, numberOfTestCases) {
+		useTables();
+	}
+	/**
+	 * @name AutoTest(PGM_P pointerPinHeaders, Stream &stream)
+	 * @param pointerPinHeaders  	address of pinHeaders file in FLASH memory
+	 * @param stream				where the test case records come from, one line each, ended by an empty line
+	 */
+	AutoTest(PGM_P pointerPinHeaders, Stream &stream)
+		: AutoTestBase(PINS, INPUT_PINS, FIELD_LENGTH, DESCRIPTION_LENGTH, pointerPinHeaders, &stream) {
+		useTables();
+	}
 
+private:
+	//
+	// a test set without input pins still needs a valid array
+	//
+	uint16_t		inputValueTable[INPUT_PINS > 0 ? INPUT_PINS : 1];
+	uint8_t			pinNumberTable[PINS];
+	uint8_t			inputPinBitTable[AUTOTEST_PIN_BITS(PINS)];
+	uint8_t			inputListTable[PINS];
+	uint8_t			digitalBitTable[AUTOTEST_PIN_BITS(PINS)];
+	uint8_t			sentDigitalBitTable[AUTOTEST_PIN_BITS(PINS)];
+	uint8_t			analogPinBitTable[AUTOTEST_PIN_BITS(PINS)];
+	uint16_t		analogValueTable[AUTOTEST_ANALOG_SLOTS(ANALOG_PINS) > 0 ? AUTOTEST_ANALOG_SLOTS(ANALOG_PINS) : 1];
+	uint16_t		sentAnalogValueTable[AUTOTEST_ANALOG_SLOTS(ANALOG_PINS) > 0 ? AUTOTEST_ANALOG_SLOTS(ANALOG_PINS) : 1];
+	uint16_t		nextExpectedTable[EXPECTED_VALUES > 0 ? EXPECTED_VALUES : 1];
+	uint16_t		expectedTable[EXPECTED_VALUES > 0 ? EXPECTED_VALUES : 1];
+	uint16_t		pinNameTable[PINS];
+	uint8_t			traceBufferTable[AUTOTEST_TRACE_BUFFER > 0 ? AUTOTEST_TRACE_BUFFER : 1];
+	uint8_t			captureBufferTable[AUTOTEST_CAPTURE_BUFFER > 0 ? AUTOTEST_CAPTURE_BUFFER : 1];
+	AutoTestLatency	latencyTable[AUTOTEST_LATENCY_STATS ? PINS : 1];
+	char			streamTable[AUTOTEST_STREAM_BUFFERS > 0 ? AUTOTEST_STREAM_BUFFERS * AUTOTEST_STREAM_RECORD_LENGTH(PINS, INPUT_PINS) : 1];
+	AutoTestGenerator nextGeneratorTable[AUTOTEST_ANALOG_GENERATORS && INPUT_PINS > 0 ? INPUT_PINS : 1];
+	AutoTestGenerator generatorTable[AUTOTEST_ANALOG_GENERATORS ? PINS : 1];
+	AutoTestInterrupt interruptTable[AUTOTEST_INTERRUPTS > 0 ? AUTOTEST_INTERRUPTS : 1];
+#ifdef AUTOTEST_COMPACT_PIN_LOOKUP
+	uint8_t			rankToIndexTable[PINS];
+#endif
+
+	/**
+	 * @name useTables()
+	 * points the base class to the tables of this object
+	 */
+	void useTables() {
+		nextInputValues	= inputValueTable;
+		pinNumbers		= pinNumberTable;
+		inputPinBits	= inputPinBitTable;
+		inputList		= inputListTable;
+		digitalBits		= digitalBitTable;
+		sentDigitalBits	= sentDigitalBitTable;
+		analogPinBits	= analogPinBitTable;
+		analogValues	= analogValueTable;
+		sentAnalogValues = sentAnalogValueTable;
+		maxAnalog		= AUTOTEST_ANALOG_SLOTS(ANALOG_PINS);
+		nextExpectedValues = nextExpectedTable;
+		expectedValues	= expectedTable;
+		maxExpected		= EXPECTED_VALUES;
+		pinNames		= pinNameTable;
+		interrupts		= interruptTable;
+		maxInterrupts	= AUTOTEST_INTERRUPTS;
+#ifdef AUTOTEST_COMPACT_PIN_LOOKUP
+		rankToIndex		= rankToIndexTable;
+#endif
+		if (AUTOTEST_TRACE_BUFFER > 0) {
+			traceBuffer.setBuffer(traceBufferTable, AUTOTEST_TRACE_BUFFER);
+			output		= &traceBuffer;
+		}
+		if (AUTOTEST_CAPTURE_BUFFER > 0) {
+			captureBuffer.setBuffer(captureBufferTable, AUTOTEST_CAPTURE_BUFFER);
+		}
+		if (AUTOTEST_LATENCY_STATS) {
+			latency		= latencyTable;
+		}
+		if (AUTOTEST_STREAM_BUFFERS > 0) {
+			streamBuffer		= streamTable;
+			streamRecordLength	= AUTOTEST_STREAM_RECORD_LENGTH(PINS, INPUT_PINS);
+		}
+		if (AUTOTEST_ANALOG_GENERATORS) {
+			nextGenerators	= nextGeneratorTable;
+			generators		= generatorTable;
+		}
+		registerState(this, sizeof(*this));		// the tables are part of this object
+	}
+};
+
+#ifdef AUTOTEST_HAS_PORTS
+/**
+ * @class AutoTestPort
+ * Stands in for a port register when the sketch defines AUTOTEST_PORTS. AutomaticTesting.h defines PORTB as
+ * AutoTestPort(autotest, PB, AUTOTEST_REGISTER_PORT) and so on, so PORTB = x, PORTB |= x and x = PINB go to
+ * AutoTest. Macros that take the address of a register (sbi(), bit_is_set()) do not work with it.
+ */
+class AutoTestPort {
+public:
+	AutoTestPort(AutoTestBase &autotest, uint8_t port, uint8_t reg) : autotest(autotest), port(port), reg(reg) {
+	}
+	operator uint8_t() const {
+		return autotest.callPortRead(port, reg);
+	}
+	AutoTestPort &operator=(uint8_t value) {
+		autotest.callPortWrite(port, reg, value);
+		return *this;
+	}
+	AutoTestPort &operator=(const AutoTestPort &other) {
+		return *this = (uint8_t)other;
+	}
+	AutoTestPort &operator|=(uint8_t value) {
+		//
+		// PINB |= x is an sbi on the board, which only writes the bits of x. Those toggle
+		//
+		if (reg == AUTOTEST_REGISTER_PIN) {
+			return *this = value;
+		}
+		return *this = (uint8_t)(*this | value);
+	}
+	AutoTestPort &operator&=(uint8_t value) {
+		return *this = (uint8_t)(*this & value);
+	}
+	AutoTestPort &operator^=(uint8_t value) {
+		return *this = (uint8_t)(*this ^ value);
+	}
+
+private:
+	AutoTestBase	&autotest;
+	uint8_t			port;								// PB, PC etc
+	uint8_t			reg;								// AUTOTEST_REGISTER_PORT, _PIN or _DDR
 };
+#endif
 
 #endif /* AUTOTEST_H_ */
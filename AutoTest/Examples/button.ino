@@ -0,0 +1,26 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard button program
+
+#ifdef AUTOTEST
+#include "AutomaticTesting.h"
+#endif
+
+#define BUTTON	2							// button between pin 2 and ground
+#define LED		13							// the LED on pin 13 shows the button
+
+void setup()
+{
+
+#ifdef AUTOTEST
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+	autotest.setOutputMode(AUTOTEST_OUTPUT_VERDICT);	// only report if the LED follows the button
+#endif
+
+	pinMode(BUTTON, INPUT_PULLUP);
+	pinMode(LED, OUTPUT);
+}
+void loop()
+{
+	digitalWrite(LED, digitalRead(BUTTON) == LOW);	// the LED is on while the button is pressed
+	delay(5);
+}
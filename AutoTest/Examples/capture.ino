@@ -0,0 +1,54 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard motor guard program
+
+#ifdef AUTOTEST
+#define AUTOTEST_CAPTURE_BUFFER	512			// history of the events before the trigger
+#include "AutomaticTesting.h"
+#endif
+
+#define OVERLOAD	2						// LOW while the motor draws too much current
+#define MOTOR		9						// the motor runs while this pin is HIGH
+#define FAULT		12						// the fault LED, on once the motor is stopped
+#define HEARTBEAT	13						// blinks all the time to show the sketch runs
+#define MAX_OVERLOAD	50					// msec of overload before the motor is stopped
+
+unsigned long beat = 0;
+unsigned long normalSince = 0;
+bool heartbeat = false;
+bool fault = false;
+
+void setup()
+{
+
+#ifdef AUTOTEST
+	autotest.registerState(&beat, sizeof(beat));	// test sets can continue from a checkpoint (host build)
+	autotest.registerState(&normalSince, sizeof(normalSince));
+	autotest.registerState(&heartbeat, sizeof(heartbeat));
+	autotest.registerState(&fault, sizeof(fault));
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+	autotest.triggerOnPin(FAULT, HIGH);		// only send what happened around the fault
+	autotest.captureOnTrigger(12, 4);
+#endif
+
+	pinMode(OVERLOAD, INPUT_PULLUP);
+	pinMode(MOTOR, OUTPUT);
+	pinMode(FAULT, OUTPUT);
+	pinMode(HEARTBEAT, OUTPUT);
+	digitalWrite(MOTOR, HIGH);
+}
+void loop()
+{
+	if (millis() - beat >= 100) {
+		beat += 100;
+		heartbeat = !heartbeat;
+		digitalWrite(HEARTBEAT, heartbeat);
+	}
+	if (digitalRead(OVERLOAD) == HIGH) {
+		normalSince = millis();
+	} else if (millis() - normalSince > MAX_OVERLOAD && !fault) {
+		fault = true;
+		digitalWrite(MOTOR, LOW);
+		digitalWrite(FAULT, HIGH);
+	}
+	delay(5);
+}
@@ -0,0 +1,33 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard interrupt program
+
+#ifdef AUTOTEST
+#include "AutomaticTesting.h"
+#endif
+
+#define BUTTON	2							// button to ground on pin 2, the pin of interrupt 0 on an UNO
+#define LED		13							// the LED on pin 13 toggles on every press
+
+volatile uint8_t presses = 0;
+
+void pressed()
+{
+	presses++;
+	digitalWrite(LED, presses & 1);
+}
+void setup()
+{
+
+#ifdef AUTOTEST
+	autotest.registerState((void *)&presses, sizeof(presses));	// test sets can continue from a checkpoint (host build)
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+#endif
+
+	pinMode(BUTTON, INPUT_PULLUP);
+	pinMode(LED, OUTPUT);
+	attachInterrupt(digitalPinToInterrupt(BUTTON), pressed, FALLING);
+}
+void loop()
+{
+	delay(1000);							// all the work is done by the interrupt handler
+}
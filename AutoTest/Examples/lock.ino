@@ -0,0 +1,68 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard code lock program
+
+#ifdef AUTOTEST
+#include "AutomaticTesting.h"
+#endif
+
+#include <assert.h>
+
+//
+// The lock opens for OPEN_TIME msec after the code short, long, long, short is pressed on the button.
+// It has a bug the test set does not find but the fuzzer does (make FUZZ=1, see fuzz/fuzzSketch.cpp):
+// a wrong code of CODE_LENGTH presses only starts over after a pause, one more quick press writes past entered
+//
+#define BUTTON		2						// button to ground on pin 2
+#define LOCK		13						// HIGH while the lock is open
+#define CODE_LENGTH	4
+#define LONG_PRESS	300						// msec, a longer press is a 1 in the code
+#define PAUSE		1000					// msec, after a longer pause the code starts over
+#define OPEN_TIME	2000					// msec the lock stays open
+
+const uint8_t code[CODE_LENGTH] = { 0, 1, 1, 0 };
+
+struct {
+	uint8_t			entered[CODE_LENGTH];
+	uint8_t			count;
+	bool			pressed;
+	unsigned long	changed;
+	unsigned long	opened;
+} lock;										// all the lock remembers, in one block for autotest.registerState()
+
+void setup()
+{
+
+#ifdef AUTOTEST
+	autotest.registerState(&lock, sizeof(lock));	// test sets can continue from a checkpoint (host build)
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+#endif
+
+	pinMode(BUTTON, INPUT_PULLUP);
+	pinMode(LOCK, OUTPUT);
+}
+void loop()
+{
+	bool down = digitalRead(BUTTON) == LOW;
+
+	if (down != lock.pressed) {
+		if (down && millis() - lock.changed > PAUSE) {
+			lock.count = 0;					// a new code
+		}
+		if (!down) {
+			assert(lock.count < CODE_LENGTH);
+			lock.entered[lock.count++] = millis() - lock.changed > LONG_PRESS;
+			if (lock.count == CODE_LENGTH && memcmp(lock.entered, code, CODE_LENGTH) == 0) {
+				digitalWrite(LOCK, HIGH);
+				lock.opened = millis();
+				lock.count = 0;
+			}
+		}
+		lock.pressed = down;
+		lock.changed = millis();
+	}
+	if (lock.opened != 0 && millis() - lock.opened > OPEN_TIME) {
+		digitalWrite(LOCK, LOW);
+		lock.opened = 0;
+	}
+	delay(5);
+}
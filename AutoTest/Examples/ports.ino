@@ -0,0 +1,38 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard counter program
+
+#ifdef AUTOTEST
+#define AUTOTEST_PORTS						// PORTB, PIND etc go to AutoTest as well
+#include "AutomaticTesting.h"
+#endif
+
+#define BUTTON	2							// button between pin 2 (PD2) and ground
+											// LEDs on pins 8-11 (PB0-PB3) show the number of presses
+
+bool pressed = false;
+uint8_t count = 0;
+
+void setup()
+{
+
+#ifdef AUTOTEST
+	autotest.registerState(&pressed, sizeof(pressed));	// test sets can continue from a checkpoint (host build)
+	autotest.registerState(&count, sizeof(count));
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+	autotest.setOutputMode(AUTOTEST_OUTPUT_VERDICT);	// only report if the LEDs count the presses
+#endif
+
+	pinMode(BUTTON, INPUT_PULLUP);
+	DDRB |= 0x0F;							// the 4 LEDs are outputs
+}
+void loop()
+{
+	bool down = (PIND & (1 << BUTTON)) == 0;
+
+	if (down && !pressed) {
+		count = (count + 1) & 0x0F;
+		PORTB = (PORTB & 0xF0) | count;		// all 4 LEDs change at the same moment
+	}
+	pressed = down;
+	delay(5);
+}
@@ -0,0 +1,38 @@
+#define AUTOTEST   // by commenting this line out, you will have a standard sensor program
+
+#ifdef AUTOTEST
+#define AUTOTEST_ANALOG_GENERATORS	1		// the test set drives the sensor with ramps, sines and noise
+#include "AutomaticTesting.h"
+#endif
+
+#define SENSOR	A0							// analog sensor on pin A0
+#define LED		13							// the LED on pin 13 shows the sensor is above the threshold
+#define ON		600							// the LED goes on above this value
+#define OFF		400							// and off again below this value, so noise does not make it flicker
+
+bool on = false;
+
+void setup()
+{
+
+#ifdef AUTOTEST
+	autotest.registerState(&on, sizeof(on));		// test sets can continue from a checkpoint (host build)
+	Serial.begin(115200);					// set the baudrate you wish to use
+	autotest.begin();
+	autotest.setOutputMode(AUTOTEST_OUTPUT_VERDICT);	// only report if the LED follows the sensor
+#endif
+
+	pinMode(LED, OUTPUT);
+}
+void loop()
+{
+	int value = analogRead(SENSOR);
+
+	if (value > ON) {
+		on = true;
+	} else if (value < OFF) {
+		on = false;
+	}
+	digitalWrite(LED, on);
+	delay(5);
+}
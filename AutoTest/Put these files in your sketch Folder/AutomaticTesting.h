@@ -20,6 +20,14 @@
 #ifndef AUTOMATIC_TESTING_H_
 #define AUTOMATIC_TESTING_H
 #include <AutoTest.h>
+#ifdef AUTOTEST_HOST_TEST_SET_FILES
+//
+// host build that reads the test set when it starts (make FILES=1), see AutoTestHost.h
+//
+#include <AutoTestHost.h>
+AutoTestHost autotest;
+AutoTestHost &autotestHostFiles = autotest;	// lets main() load the test set
+#else
 //
 // get the generated headers. The trick used here is that there are files generated from the Excel sheet. These files
 // are put in between the const and ";"
@@ -27,10 +35,34 @@
 const PROGMEM char pinHeaders[] =
 #include "pinHeaders.h"
 ;
+#include "FieldLengths.h"
+#ifndef MAX_EXPECTED_VALUES
+#define MAX_EXPECTED_VALUES NUMBER_OF_PINS		// FieldLengths.h of generateTestSets.xls does not count them
+#endif
+#ifndef NUMBER_OF_ANALOG_PINS
+#define NUMBER_OF_ANALOG_PINS NUMBER_OF_PINS	// nor the analog pins, so every pin can be one
+#endif
+#if defined(AUTOTEST_STREAM_TEST_CASES)
+//
+// the test cases come in over Serial from a feeder (host/tools/feedTestCases). Define AUTOTEST_STREAM_TEST_CASES in
+// the sketch before including this file. TestCases.h is not needed
+//
+#elif defined(AUTOTEST_PACKED_TEST_CASES)
+//
+// packed test cases (generated with packTestCases from TestCases.h). Define AUTOTEST_PACKED_TEST_CASES in the sketch
+// before including this file to use them
+//
+const PROGMEM uint16_t testCases[] = {
+#include "TestCaseRecords.h"
+};
+const PROGMEM char testCaseDescriptions[] =
+#include "TestCaseDescriptions.h"
+;
+#else
 const PROGMEM char testCases[] =
 #include "TestCases.h"
 ;
-#include "FieldLengths.h"
+#endif
 //
 // end getting generated headers
 //
@@ -38,9 +70,30 @@ const PROGMEM char testCases[] =
 //
 // Create the AutTest object
 //
-AutoTest autotest(NUMBER_OF_PINS,NUMBER_OF_INPUT_PINS,MAX_FIELD_LENGTH,MAX_DESCRIPTION_LENGTH, pinHeaders, testCases);
+#if defined(AUTOTEST_STREAM_TEST_CASES)
+AutoTest<NUMBER_OF_PINS,NUMBER_OF_INPUT_PINS,MAX_FIELD_LENGTH,MAX_DESCRIPTION_LENGTH,MAX_EXPECTED_VALUES,NUMBER_OF_ANALOG_PINS> autotest(pinHeaders, Serial);
+#elif defined(AUTOTEST_PACKED_TEST_CASES)
+AutoTest<NUMBER_OF_PINS,NUMBER_OF_INPUT_PINS,MAX_FIELD_LENGTH,MAX_DESCRIPTION_LENGTH,MAX_EXPECTED_VALUES,NUMBER_OF_ANALOG_PINS> autotest(pinHeaders, testCases,
+		testCaseDescriptions, sizeof(testCases) / sizeof(testCases[0]) / AUTOTEST_PACKED_RECORD_WORDS(NUMBER_OF_INPUT_PINS));
+#else
+AutoTest<NUMBER_OF_PINS,NUMBER_OF_INPUT_PINS,MAX_FIELD_LENGTH,MAX_DESCRIPTION_LENGTH,MAX_EXPECTED_VALUES,NUMBER_OF_ANALOG_PINS> autotest(pinHeaders, testCases);
+#endif
+#endif // AUTOTEST_HOST_TEST_SET_FILES
+#ifdef AUTOTEST_HOST
+AutoTestBase &autotestHost = autotest;		// lets main() of the host build reach autotest
+#endif
+#if AUTOTEST_TRACE_BUFFER > 0 && !defined(AUTOTEST_OWN_YIELD)
+//
+// the trace buffer is sent to Serial whenever the sketch waits. delay() calls yield() while it waits. A sketch with
+// its own yield() defines AUTOTEST_OWN_YIELD and calls autotest.flush() from it
 //
-// redefine functions to replace the original pinMode(), digitalRead() and digitalWrite() functions
+void yield() {
+	autotest.flush();
+}
+#endif
+//
+// redefine functions to replace the original pinMode(), digitalRead() and digitalWrite() functions, the time
+// functions so AutoTest controls the clock and attachInterrupt() so the test cases call the handlers
 //
 
 #define pinMode(a,b)		autotest.callPinMode(a,b)
@@ -48,5 +101,104 @@ AutoTest autotest(NUMBER_OF_PINS,NUMBER_OF_INPUT_PINS,MAX_FIELD_LENGTH,MAX_DESCR
 #define digitalWrite(a,b)	autotest.callDigitalWrite(a, b)
 #define analogRead(a)		autotest.callAnalogRead(a)
 #define analogWrite(a,b)	autotest.callAnalogWrite(a, b)
+#define millis()			autotest.callMillis()
+#define micros()			autotest.callMicros()
+#define delay(a)			autotest.callDelay(a)
+#define delayMicroseconds(a)	autotest.callDelayMicroseconds(a)
+#define attachInterrupt(a,b,c)	autotest.callAttachInterrupt(a, b, c)
+#define detachInterrupt(a)		autotest.callDetachInterrupt(a)
+#if defined(AUTOTEST_PORTS) && defined(AUTOTEST_HAS_PORTS)
+//
+// and the port registers, see AutoTestPort
+//
+#ifdef PORTA
+#undef PORTA
+#undef PINA
+#undef DDRA
+#define PORTA	AutoTestPort(autotest, PA, AUTOTEST_REGISTER_PORT)
+#define PINA	AutoTestPort(autotest, PA, AUTOTEST_REGISTER_PIN)
+#define DDRA	AutoTestPort(autotest, PA, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTB
+#undef PORTB
+#undef PINB
+#undef DDRB
+#define PORTB	AutoTestPort(autotest, PB, AUTOTEST_REGISTER_PORT)
+#define PINB	AutoTestPort(autotest, PB, AUTOTEST_REGISTER_PIN)
+#define DDRB	AutoTestPort(autotest, PB, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTC
+#undef PORTC
+#undef PINC
+#undef DDRC
+#define PORTC	AutoTestPort(autotest, PC, AUTOTEST_REGISTER_PORT)
+#define PINC	AutoTestPort(autotest, PC, AUTOTEST_REGISTER_PIN)
+#define DDRC	AutoTestPort(autotest, PC, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTD
+#undef PORTD
+#undef PIND
+#undef DDRD
+#define PORTD	AutoTestPort(autotest, PD, AUTOTEST_REGISTER_PORT)
+#define PIND	AutoTestPort(autotest, PD, AUTOTEST_REGISTER_PIN)
+#define DDRD	AutoTestPort(autotest, PD, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTE
+#undef PORTE
+#undef PINE
+#undef DDRE
+#define PORTE	AutoTestPort(autotest, PE, AUTOTEST_REGISTER_PORT)
+#define PINE	AutoTestPort(autotest, PE, AUTOTEST_REGISTER_PIN)
+#define DDRE	AutoTestPort(autotest, PE, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTF
+#undef PORTF
+#undef PINF
+#undef DDRF
+#define PORTF	AutoTestPort(autotest, PF, AUTOTEST_REGISTER_PORT)
+#define PINF	AutoTestPort(autotest, PF, AUTOTEST_REGISTER_PIN)
+#define DDRF	AutoTestPort(autotest, PF, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTG
+#undef PORTG
+#undef PING
+#undef DDRG
+#define PORTG	AutoTestPort(autotest, PG, AUTOTEST_REGISTER_PORT)
+#define PING	AutoTestPort(autotest, PG, AUTOTEST_REGISTER_PIN)
+#define DDRG	AutoTestPort(autotest, PG, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTH
+#undef PORTH
+#undef PINH
+#undef DDRH
+#define PORTH	AutoTestPort(autotest, PH, AUTOTEST_REGISTER_PORT)
+#define PINH	AutoTestPort(autotest, PH, AUTOTEST_REGISTER_PIN)
+#define DDRH	AutoTestPort(autotest, PH, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTJ
+#undef PORTJ
+#undef PINJ
+#undef DDRJ
+#define PORTJ	AutoTestPort(autotest, PJ, AUTOTEST_REGISTER_PORT)
+#define PINJ	AutoTestPort(autotest, PJ, AUTOTEST_REGISTER_PIN)
+#define DDRJ	AutoTestPort(autotest, PJ, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTK
+#undef PORTK
+#undef PINK
+#undef DDRK
+#define PORTK	AutoTestPort(autotest, PK, AUTOTEST_REGISTER_PORT)
+#define PINK	AutoTestPort(autotest, PK, AUTOTEST_REGISTER_PIN)
+#define DDRK	AutoTestPort(autotest, PK, AUTOTEST_REGISTER_DDR)
+#endif
+#ifdef PORTL
+#undef PORTL
+#undef PINL
+#undef DDRL
+#define PORTL	AutoTestPort(autotest, PL, AUTOTEST_REGISTER_PORT)
+#define PINL	AutoTestPort(autotest, PL, AUTOTEST_REGISTER_PIN)
+#define DDRL	AutoTestPort(autotest, PL, AUTOTEST_REGISTER_DDR)
+#endif
+#endif
 
 #endif /* AUTOMATIC_TESTING_H */
@@ -0,0 +1,306 @@
+/**
+ * @file Arduino.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Implementation of the minimal Arduino core used for the host build. See Arduino.h
+ */
+#include "Arduino.h"
+
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+#include <poll.h>
+
+HardwareSerial Serial;
+
+//
+// the clock starts at 0 when the program starts just like on the board
+//
+static struct timespec startTime;
+static bool            clockStarted = false;
+
+/**
+ * @name elapsedMicros()
+ * @returns unsigned long microseconds since the first call
+ */
+static unsigned long elapsedMicros() {
+	struct timespec now;
+
+	if (!clockStarted) {
+		clock_gettime(CLOCK_MONOTONIC, &startTime);
+		clockStarted = true;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (unsigned long)(now.tv_sec - startTime.tv_sec) * 1000000UL
+		 + (unsigned long)((now.tv_nsec - startTime.tv_nsec) / 1000L);
+}
+
+unsigned long millis() {
+	return elapsedMicros() / 1000UL;
+}
+
+unsigned long micros() {
+	return elapsedMicros();
+}
+
+void delay(unsigned long ms) {
+	Serial.flush();
+	usleep(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us) {
+	usleep(us);
+}
+
+//
+// like on the board a sketch (or AutomaticTesting.h) can have its own yield()
+//
+__attribute__((weak)) void yield() {
+}
+
+//
+// the pin functions do nothing. AutomaticTesting.h reroutes them to AutoTest
+//
+void pinMode(uint8_t, uint8_t) {
+}
+
+void digitalWrite(uint8_t, uint8_t) {
+}
+
+int digitalRead(uint8_t) {
+	return LOW;
+}
+
+int analogRead(uint8_t) {
+	return 0;
+}
+
+void analogWrite(uint8_t, int) {
+}
+
+void attachInterrupt(uint8_t, void (*)(), int) {
+}
+
+void detachInterrupt(uint8_t) {
+}
+
+//
+// the handlers run from AutoTest in between the code of the sketch, so there is nothing to lock
+//
+void interrupts() {
+}
+
+void noInterrupts() {
+}
+
+volatile uint8_t hostRegisters[9];
+
+//
+// same linear congruential generator on every run so the results are reproducible
+//
+static unsigned long randomState = 1;
+
+void randomSeed(unsigned long seed) {
+	if (seed != 0) {
+		randomState = seed;
+	}
+}
+
+long random(long howBig) {
+	if (howBig == 0) {
+		return 0;
+	}
+	randomState = randomState * 1103515245UL + 12345UL;
+	return (long)((randomState >> 16) & 0x7FFFFFFFUL) % howBig;
+}
+
+long random(long howSmall, long howBig) {
+	if (howSmall >= howBig) {
+		return howSmall;
+	}
+	return random(howBig - howSmall) + howSmall;
+}
+
+/**
+ * @name ultoa(unsigned long value, char *str, int base)
+ * avr-libc conversion of a number to a string. itoa(), ltoa() and utoa() use this one as well
+ */
+char *ultoa(unsigned long value, char *str, int base) {
+	char	buffer[8 * sizeof(unsigned long) + 1];
+	char	*ptr = &buffer[sizeof(buffer) - 1];
+
+	if (base < 2 || base > 36) {
+		base = 10;
+	}
+	*ptr = '\0';
+	do {
+		unsigned long digit = value % base;
+		*--ptr = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+		value /= base;
+	} while (value != 0);
+	return strcpy(str, ptr);
+}
+
+char *ltoa(long value, char *str, int base) {
+	if (value < 0 && base == 10) {
+		str[0] = '-';
+		ultoa(-(unsigned long)value, &str[1], base);
+		return str;
+	}
+	return ultoa((unsigned long)value, str, base);
+}
+
+char *itoa(int value, char *str, int base) {
+	if (value < 0 && base == 10) {
+		return ltoa(value, str, base);
+	}
+	return ultoa((unsigned int)value, str, base);
+}
+
+char *utoa(unsigned int value, char *str, int base) {
+	return ultoa(value, str, base);
+}
+
+/**
+ * Print
+ */
+size_t Print::write(const uint8_t *buffer, size_t size) {
+	size_t n = 0;
+	while (size--) {
+		n += write(*buffer++);
+	}
+	return n;
+}
+
+size_t Print::printNumber(unsigned long n, uint8_t base) {
+	char buffer[8 * sizeof(unsigned long) + 1];
+
+	ultoa(n, buffer, base);
+	return write(buffer);
+}
+
+size_t Print::print(const __FlashStringHelper *ifsh) {
+	return write(reinterpret_cast<const char *>(ifsh));
+}
+
+size_t Print::print(const char str[]) {
+	return write(str);
+}
+
+size_t Print::print(char c) {
+	return write((uint8_t)c);
+}
+
+size_t Print::print(unsigned char b, int base) {
+	return print((unsigned long)b, base);
+}
+
+size_t Print::print(int n, int base) {
+	return print((long)n, base);
+}
+
+size_t Print::print(unsigned int n, int base) {
+	return print((unsigned long)n, base);
+}
+
+size_t Print::print(long n, int base) {
+	if (base == 10 && n < 0) {
+		return write('-') + printNumber(-(unsigned long)n, 10);
+	}
+	if (base == 10) {
+		return printNumber(n, 10);
+	}
+	return printNumber((unsigned long)n, base);
+}
+
+size_t Print::print(unsigned long n, int base) {
+	if (base == 0) {
+		return write((uint8_t)n);
+	}
+	return printNumber(n, base);
+}
+
+size_t Print::print(double number, int digits) {
+	char buffer[48];
+
+	snprintf(buffer, sizeof(buffer), "%.*f", digits, number);
+	return write(buffer);
+}
+
+size_t Print::println() {
+	return write("\r\n");
+}
+
+size_t Print::println(const __FlashStringHelper *ifsh)	{ size_t n = print(ifsh);		return n + println(); }
+size_t Print::println(const char c[])					{ size_t n = print(c);			return n + println(); }
+size_t Print::println(char c)							{ size_t n = print(c);			return n + println(); }
+size_t Print::println(unsigned char b, int base)		{ size_t n = print(b, base);	return n + println(); }
+size_t Print::println(int num, int base)				{ size_t n = print(num, base);	return n + println(); }
+size_t Print::println(unsigned int num, int base)		{ size_t n = print(num, base);	return n + println(); }
+size_t Print::println(long num, int base)				{ size_t n = print(num, base);	return n + println(); }
+size_t Print::println(unsigned long num, int base)		{ size_t n = print(num, base);	return n + println(); }
+size_t Print::println(double num, int digits)			{ size_t n = print(num, digits);	return n + println(); }
+
+/**
+ * Stream
+ */
+size_t Stream::readBytes(char *buffer, size_t length) {
+	size_t count = 0;
+	while (count < length) {
+		int c = read();
+		if (c < 0) {
+			break;
+		}
+		*buffer++ = (char)c;
+		count++;
+	}
+	return count;
+}
+
+/**
+ * HardwareSerial
+ * Output is buffered by stdio. Input is read directly from file descriptor 0 so available() never blocks
+ */
+static uint8_t	inputBuffer[256];
+static size_t	inputHead = 0;
+static size_t	inputTail = 0;
+
+size_t HardwareSerial::write(uint8_t c) {
+	putchar_unlocked(c);
+	return 1;
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size) {
+	return fwrite_unlocked(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush() {
+	fflush(stdout);
+}
+
+int HardwareSerial::available() {
+	if (inputHead == inputTail) {
+		struct pollfd pfd = { 0, POLLIN, 0 };
+		if (poll(&pfd, 1, 0) > 0 && (pfd.revents & POLLIN)) {
+			ssize_t n = ::read(0, inputBuffer, sizeof(inputBuffer));
+			inputHead = 0;
+			inputTail = n > 0 ? (size_t)n : 0;
+		}
+	}
+	return (int)(inputTail - inputHead);
+}
+
+int HardwareSerial::read() {
+	if (available() == 0) {
+		return -1;
+	}
+	return inputBuffer[inputHead++];
+}
+
+int HardwareSerial::peek() {
+	if (available() == 0) {
+		return -1;
+	}
+	return inputBuffer[inputHead];
+}
@@ -0,0 +1,213 @@
+/**
+ * @file Arduino.h
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Minimal Arduino core for building AutoTest and a sketch as a native (Linux) program. It only contains
+ * what AutoTest, AutomaticTesting.h and simple sketches need:
+ * \n - PROGMEM is plain memory and the _P string functions map to their normal counterparts
+ * \n - Serial writes to stdout
+ * \n - the pin and mode constants and the port layout of a standard Arduino UNO
+ * \n - pinMode(), digitalRead() etc. are harmless stubs as AutomaticTesting.h reroutes them anyway
+ *
+ * AUTOTEST_HOST is defined so AutoTest can tell it is running on the host.
+ */
+
+#ifndef ARDUINO_H_
+#define ARDUINO_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#ifndef AUTOTEST_HOST
+#define AUTOTEST_HOST
+#endif
+
+#define ARDUINO 10805
+//
+// basic types and constants
+//
+typedef bool		boolean;
+typedef uint8_t		byte;
+typedef uint16_t	word;
+
+#define HIGH			0x1
+#define LOW				0x0
+
+#define INPUT			0x0
+#define OUTPUT			0x1
+#define INPUT_PULLUP	0x2
+
+#define CHANGE			1
+#define FALLING			2
+#define RISING			3
+
+#define DEC 10
+#define HEX 16
+#define OCT 8
+#define BIN 2
+
+#define NUM_DIGITAL_PINS	20
+#define NUM_ANALOG_INPUTS	6
+
+#define A0	14
+#define A1	15
+#define A2	16
+#define A3	17
+#define A4	18
+#define A5	19
+
+#define LED_BUILTIN	13
+//
+// the ports of an UNO: pins 0-7 are port D, 8-13 port B and A0-A5 port C. The registers are plain bytes, a sketch
+// built with AUTOTEST_PORTS uses the AutoTest proxies instead
+//
+#define NOT_A_PORT	0
+#define PB			2
+#define PC			3
+#define PD			4
+
+#define NOT_AN_INTERRUPT	-1
+#define digitalPinToInterrupt(P)	((P) == 2 ? 0 : (P) == 3 ? 1 : NOT_AN_INTERRUPT)
+
+#define digitalPinToPort(P)		((P) < 8 ? PD : (P) < 14 ? PB : (P) < 20 ? PC : NOT_A_PORT)
+#define digitalPinToBitMask(P)	((uint8_t)(1 << ((P) < 8 ? (P) : (P) < 14 ? (P) - 8 : (P) - 14)))
+
+extern volatile uint8_t hostRegisters[9];
+#define PORTB	hostRegisters[0]
+#define PINB	hostRegisters[1]
+#define DDRB	hostRegisters[2]
+#define PORTC	hostRegisters[3]
+#define PINC	hostRegisters[4]
+#define DDRC	hostRegisters[5]
+#define PORTD	hostRegisters[6]
+#define PIND	hostRegisters[7]
+#define DDRD	hostRegisters[8]
+//
+// program memory is just normal memory on the host
+//
+#define PROGMEM
+#define PGM_P						const char *
+#define PSTR(s)						(s)
+#define pgm_read_byte(addr)			(*(const uint8_t *)(addr))
+#define pgm_read_word(addr)			(*(const uint16_t *)(addr))
+#define pgm_read_dword(addr)		(*(const uint32_t *)(addr))
+#define pgm_read_ptr(addr)			(*(void * const *)(addr))
+#define strchr_P(s, c)				strchr((s), (c))
+#define strlen_P(s)					strlen((s))
+#define strcpy_P(d, s)				strcpy((d), (s))
+#define strncpy_P(d, s, n)			strncpy((d), (s), (n))
+#define strcmp_P(a, b)				strcmp((a), (b))
+#define memcpy_P(d, s, n)			memcpy((d), (s), (n))
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(PSTR(s)))
+//
+// avr-libc extensions
+//
+char *itoa(int value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+char *utoa(unsigned int value, char *str, int base);
+char *ultoa(unsigned long value, char *str, int base);
+//
+// core functions
+//
+unsigned long	millis();
+unsigned long	micros();
+void			delay(unsigned long ms);
+void			delayMicroseconds(unsigned int us);
+void			yield();
+
+void			pinMode(uint8_t pin, uint8_t mode);
+void			digitalWrite(uint8_t pin, uint8_t val);
+int				digitalRead(uint8_t pin);
+int				analogRead(uint8_t pin);
+void			analogWrite(uint8_t pin, int val);
+void			attachInterrupt(uint8_t interrupt, void (*handler)(), int mode);
+void			detachInterrupt(uint8_t interrupt);
+void			interrupts();
+void			noInterrupts();
+
+long			random(long howBig);
+long			random(long howSmall, long howBig);
+void			randomSeed(unsigned long seed);
+
+void			setup();
+void			loop();
+
+/**
+ * @class Print
+ * Same interface as the Arduino Print class. Derived classes only have to implement write(uint8_t)
+ */
+class Print {
+public:
+	virtual ~Print() {}
+	virtual size_t write(uint8_t) = 0;
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	size_t write(const char *str)					{ return str == NULL ? 0 : write((const uint8_t *)str, strlen(str)); }
+	size_t write(const char *buffer, size_t size)	{ return write((const uint8_t *)buffer, size); }
+	virtual int availableForWrite()					{ return 0; }
+	virtual void flush()							{}
+
+	size_t print(const __FlashStringHelper *);
+	size_t print(const char[]);
+	size_t print(char);
+	size_t print(unsigned char, int = DEC);
+	size_t print(int, int = DEC);
+	size_t print(unsigned int, int = DEC);
+	size_t print(long, int = DEC);
+	size_t print(unsigned long, int = DEC);
+	size_t print(double, int = 2);
+
+	size_t println(const __FlashStringHelper *);
+	size_t println(const char[]);
+	size_t println(char);
+	size_t println(unsigned char, int = DEC);
+	size_t println(int, int = DEC);
+	size_t println(unsigned int, int = DEC);
+	size_t println(long, int = DEC);
+	size_t println(unsigned long, int = DEC);
+	size_t println(double, int = 2);
+	size_t println();
+
+private:
+	size_t printNumber(unsigned long, uint8_t);
+};
+
+/**
+ * @class Stream
+ * Print with an input side
+ */
+class Stream : public Print {
+public:
+	virtual int available() = 0;
+	virtual int read() = 0;
+	virtual int peek() = 0;
+	size_t readBytes(char *buffer, size_t length);
+};
+
+/**
+ * @class HardwareSerial
+ * Serial port on the host. Output goes to stdout, input comes from stdin
+ */
+class HardwareSerial : public Stream {
+public:
+	void begin(unsigned long)				{}
+	void end()								{ flush(); }
+	virtual size_t write(uint8_t);
+	virtual size_t write(const uint8_t *buffer, size_t size);
+	using Print::write;
+	virtual int availableForWrite()			{ return 4096; }
+	virtual void flush();
+	virtual int available();
+	virtual int read();
+	virtual int peek();
+	operator bool()							{ return true; }
+};
+
+extern HardwareSerial Serial;
+
+#endif /* ARDUINO_H_ */
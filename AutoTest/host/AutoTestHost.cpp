@@ -0,0 +1,198 @@
+/**
+ * @file AutoTestHost.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * AutoTest with a test set read at runtime. See AutoTestHost.h
+ */
+#include "AutoTestHost.h"
+#include "tools/headerFiles.h"
+
+static const char noRecords[] = "\n";		// an empty test set until load() is called
+
+/**
+ * @name AutoTestHost()
+ * Constructor. The object has no pins and no test cases until load() is called
+ */
+AutoTestHost::AutoTestHost() : AutoTestBase(0, 0, 0, 0, noRecords, noRecords) {
+}
+
+/**
+ * @name load(const char *folder, std::string &error)
+ * @param folder	folder with pinHeaders.h, TestCases.h and FieldLengths.h
+ * @returns bool	false if a file cannot be read. error tells why
+ * Reads the test set and sizes the tables like AutoTest<> does with the defines from FieldLengths.h. Must be called
+ * before begin()
+ */
+bool AutoTestHost::load(const char *folder, std::string &error) {
+	std::string	path = std::string(folder) + "/";
+	std::string	source;
+	long		pins;
+	long		inputPins;
+	long		fieldLength;
+	long		descriptionLength;
+
+	if (!readFile((path + "FieldLengths.h").c_str(), source)) {
+		error = "cannot read " + path + "FieldLengths.h";
+		return false;
+	}
+	pins				= defineValue(source, "NUMBER_OF_PINS");
+	inputPins			= defineValue(source, "NUMBER_OF_INPUT_PINS");
+	fieldLength			= defineValue(source, "MAX_FIELD_LENGTH");
+	descriptionLength	= defineValue(source, "MAX_DESCRIPTION_LENGTH");
+	if (pins < 0 || pins > 255 || inputPins < 0 || inputPins > pins || fieldLength < 1 || fieldLength > 255 ||
+		descriptionLength < 0 || descriptionLength > 255) {
+		error = path + "FieldLengths.h has missing or invalid sizes";
+		return false;
+	}
+	source.clear();
+	if (!readFile((path + "pinHeaders.h").c_str(), source)) {
+		error = "cannot read " + path + "pinHeaders.h";
+		return false;
+	}
+	pinHeaderText = stringLiterals(source);
+	source.clear();
+	if (!readFile((path + "TestCases.h").c_str(), source)) {
+		error = "cannot read " + path + "TestCases.h";
+		return false;
+	}
+	testCaseText = stringLiterals(source);
+	//
+	// the sizes come from the same generator as the records, but a wrong folder would overwrite the tables
+	//
+	std::vector<PinHeader>	pinList;
+	std::vector<TestCase>	testCaseList;
+
+	if (!parsePinHeaders(pinHeaderText, pinList, error) || !parseTestCases(testCaseText, inputPins, testCaseList, error)) {
+		error = path + ": " + error;
+		return false;
+	}
+	if ((long)pinList.size() != pins) {
+		error = path + "pinHeaders.h does not have NUMBER_OF_PINS pins";
+		return false;
+	}
+	for (size_t i = 0; i < pinList.size(); i++) {
+		if ((long)pinList[i].name.size() >= fieldLength) {
+			error = path + "pinHeaders.h pin name " + pinList[i].name + " is longer than MAX_FIELD_LENGTH";
+			return false;
+		}
+	}
+	for (size_t i = 0; i < testCaseList.size(); i++) {
+		if (testCaseList[i].description.size() > 25) {
+			error = path + "TestCases.h description " + testCaseList[i].description + " is longer than 25";
+			return false;
+		}
+	}
+	//
+	// same as the AutoTest<> template
+	//
+	Number_Of_Pins			= pins;
+	Number_Of_Input_Pins	= inputPins;
+	Max_Field_Length		= fieldLength;
+	Max_Description_Length	= descriptionLength;
+	pinHeaders				= pinHeaderText.c_str();
+	testCases				= testCaseText.c_str();
+
+	inputValueTable.assign(inputPins > 0 ? inputPins : 1, 0);
+	pinNumberTable.assign(pins, 0);
+	inputPinBitTable.assign(AUTOTEST_PIN_BITS(pins), 0);
+	inputListTable.assign(pins, 0);
+	digitalBitTable.assign(AUTOTEST_PIN_BITS(pins), 0);
+	sentDigitalBitTable.assign(AUTOTEST_PIN_BITS(pins), 0);
+	analogPinBitTable.assign(AUTOTEST_PIN_BITS(pins), 0);
+	analogValueTable.assign(pins, 0);
+	sentAnalogValueTable.assign(pins, 0);
+	nextExpectedTable.assign(pins, 0);
+	expectedTable.assign(pins, 0);
+	pinNameTable.assign(pins, 0);
+	nextInputValues	= inputValueTable.data();
+	pinNumbers		= pinNumberTable.data();
+	inputPinBits	= inputPinBitTable.data();
+	inputList		= inputListTable.data();
+	digitalBits		= digitalBitTable.data();
+	sentDigitalBits	= sentDigitalBitTable.data();
+	analogPinBits	= analogPinBitTable.data();
+	analogValues	= analogValueTable.data();
+	sentAnalogValues = sentAnalogValueTable.data();
+	maxAnalog		= pins;				// every pin can be analog
+	nextExpectedValues = nextExpectedTable.data();
+	expectedValues	= expectedTable.data();
+	maxExpected		= pins;				// the other test sets of a tree may have checks this one has not
+	pinNames		= pinNameTable.data();
+	//
+	// memory is no issue on the host, so the generators can always be used
+	//
+	nextGeneratorTable.assign(inputPins > 0 ? inputPins : 1, AutoTestGenerator());
+	generatorTable.assign(pins, AutoTestGenerator());
+	nextGenerators	= nextGeneratorTable.data();
+	generators		= generatorTable.data();
+	interruptTable.assign(pins, AutoTestInterrupt());
+	interrupts		= interruptTable.data();
+	maxInterrupts	= pins;				// and every pin can have an interrupt handler
+	captureBufferTable.assign(AUTOTEST_HOST_CAPTURE_BUFFER, 0);
+	captureBuffer.setBuffer(captureBufferTable.data(), AUTOTEST_HOST_CAPTURE_BUFFER);
+#ifdef AUTOTEST_COMPACT_PIN_LOOKUP
+	rankToIndexTable.assign(pins, 0);
+	rankToIndex		= rankToIndexTable.data();
+#endif
+	//
+	// the tables do not move from here on, so a checkpoint can copy them back. Only the AutoTestBase part of this object
+	// is copied as it is, the strings and vectors are not plain memory. The texts do not change after load() and the
+	// contents of the vectors are registered one by one
+	//
+	numberOfStateBlocks = 0;
+	registerState(static_cast<AutoTestBase *>(this), sizeof(AutoTestBase));
+	registerTable(inputValueTable);
+	registerTable(inputPinBitTable);
+	registerTable(inputListTable);
+	registerTable(digitalBitTable);
+	registerTable(sentDigitalBitTable);
+	registerTable(analogPinBitTable);
+	registerTable(analogValueTable);
+	registerTable(sentAnalogValueTable);
+	registerTable(nextExpectedTable);
+	registerTable(expectedTable);
+	registerTable(nextGeneratorTable);
+	registerTable(generatorTable);
+	registerTable(interruptTable);
+	registerTable(captureBufferTable);
+	return true;
+}
+
+/**
+ * @name loadTestCases(const char *folder, std::string &records, std::string &error)
+ * @param folder	folder of another test set for the same pins
+ * @param records	gets the CSV of its TestCases.h
+ * @returns bool	false if the files cannot be read or the pins are not those of the test set loaded
+ */
+bool AutoTestHost::loadTestCases(const char *folder, std::string &records, std::string &error) {
+	std::string				path = std::string(folder) + "/";
+	std::string				source;
+	std::vector<TestCase>	testCaseList;
+
+	if (!readFile((path + "pinHeaders.h").c_str(), source)) {
+		error = "cannot read " + path + "pinHeaders.h";
+		return false;
+	}
+	if (stringLiterals(source) != pinHeaderText) {
+		error = path + "pinHeaders.h has other pins than the first test set";
+		return false;
+	}
+	source.clear();
+	if (!readFile((path + "TestCases.h").c_str(), source)) {
+		error = "cannot read " + path + "TestCases.h";
+		return false;
+	}
+	records = stringLiterals(source);
+	if (!parseTestCases(records, Number_Of_Input_Pins, testCaseList, error)) {
+		error = path + ": " + error;
+		return false;
+	}
+	for (size_t i = 0; i < testCaseList.size(); i++) {
+		if (testCaseList[i].description.size() > 25) {
+			error = path + "TestCases.h description " + testCaseList[i].description + " is longer than 25";
+			return false;
+		}
+	}
+	return true;
+}
@@ -0,0 +1,67 @@
+/**
+ * @file AutoTestHost.h
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * AutoTest for the host build that reads its test set when the program starts instead of compiling it in. The
+ * sketch is built once (make FILES=1) and then runs any test set folder with the generated headers
+ * (pinHeaders.h, TestCases.h and FieldLengths.h):
+ * \n blink-files testsets/blink
+ *
+ * A sketch keeps its state in globals, so each test set runs in its own process. tools/runTestSets starts these
+ * processes on all cores. Test sets that start with the same test cases can also run in one process, each continuing
+ * from a checkpoint of the one before (see main.cpp)
+ */
+
+#ifndef AUTOTESTHOST_H_
+#define AUTOTESTHOST_H_
+
+#include "AutoTest.h"
+
+#include <string>
+#include <vector>
+
+#define AUTOTEST_HOST_CAPTURE_BUFFER	16384	// bytes of history for captureOnTrigger(), memory is no issue here
+
+/**
+ * @class AutoTestHost
+ * AutoTest with the tables sized at runtime by load()
+ */
+class AutoTestHost : public AutoTestBase {
+public:
+	AutoTestHost();
+	bool load(const char *folder, std::string &error);	// reads the test set in folder
+	bool loadTestCases(const char *folder, std::string &records, std::string &error);	// test cases for the same pins
+
+private:
+	/**
+	 * @name registerTable(std::vector<T> &table)
+	 * makes the table part of the checkpoints
+	 */
+	template <typename T> void registerTable(std::vector<T> &table) {
+		registerState(table.data(), table.size() * sizeof(T));
+	}
+	std::string				pinHeaderText;				// CSV of pinHeaders.h
+	std::string				testCaseText;				// CSV of TestCases.h
+	std::vector<uint16_t>	inputValueTable;
+	std::vector<uint8_t>	pinNumberTable;
+	std::vector<uint8_t>	inputPinBitTable;
+	std::vector<uint8_t>	inputListTable;
+	std::vector<uint8_t>	digitalBitTable;
+	std::vector<uint8_t>	sentDigitalBitTable;
+	std::vector<uint8_t>	analogPinBitTable;
+	std::vector<uint16_t>	analogValueTable;
+	std::vector<uint16_t>	sentAnalogValueTable;
+	std::vector<uint16_t>	nextExpectedTable;
+	std::vector<uint16_t>	expectedTable;
+	std::vector<uint16_t>	pinNameTable;
+	std::vector<AutoTestGenerator> nextGeneratorTable;
+	std::vector<AutoTestGenerator> generatorTable;
+	std::vector<AutoTestInterrupt> interruptTable;
+	std::vector<uint8_t>	captureBufferTable;
+#ifdef AUTOTEST_COMPACT_PIN_LOOKUP
+	std::vector<uint8_t>	rankToIndexTable;
+#endif
+};
+
+#endif /* AUTOTESTHOST_H_ */
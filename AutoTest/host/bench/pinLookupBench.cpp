@@ -0,0 +1,81 @@
+/**
+ * @file pinLookupBench.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Measures the cost of an intercepted digitalRead() for a growing number of pins in the test set. The program is
+ * built once for each pin lookup (see AutoTest.h) so the results can be compared:
+ * \n make bench
+ *
+ * Output is CSV: lookup method;number of pins;nsec per read
+ * Each read goes to a different pin so the average over all the pins in the test set is measured.
+ */
+#include <Arduino.h>
+#include <AutoTest.h>
+
+#include <stdio.h>
+#include <time.h>
+
+#ifndef BENCH_NAME
+#define BENCH_NAME		"table"
+#endif
+#define BENCH_READS		4000000UL			// number of reads per measurement
+
+static const char noTestCases[] = "\n";		// the test set has no test cases
+
+/**
+ * @name nsecNow()
+ * @returns double	monotonic time in nsec
+ */
+static double nsecNow() {
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+/**
+ * @name measure<PINS>()
+ * Builds a test set with pins 0 .. PINS - 1, reads all of them round robin and prints the nsec per read
+ */
+template <uint8_t PINS>
+static void measure() {
+	static char		pinHeaders[PINS * 10 + 2];
+	char			*ptr		= pinHeaders;
+	AutoTest<PINS, PINS, 5, 26>	*autotest;
+	volatile uint8_t sum		= 0;
+	double			start;
+
+	for (uint8_t i = 0; i < PINS; i++) {
+		ptr += sprintf(ptr, "%u,P%u\n", i, i);
+	}
+	strcpy(ptr, "\n");
+
+	autotest = new AutoTest<PINS, PINS, 5, 26>(pinHeaders, noTestCases);
+	autotest->begin();
+	autotest->doNotDisplayReadsIf(0);		// all values are 0 so nothing is sent to Serial
+
+	start = nsecNow();
+	for (unsigned long i = 0, pin = 0; i < BENCH_READS; i++) {
+		sum += autotest->callDigitalRead(pin);
+		if (++pin == PINS) {
+			pin = 0;
+		}
+	}
+	printf("%s;%u;%.2f\n", BENCH_NAME, PINS, (nsecNow() - start) / BENCH_READS);
+	delete autotest;
+}
+
+int main() {
+	measure<1>();
+	measure<2>();
+	measure<4>();
+	measure<8>();
+	measure<16>();
+	measure<32>();
+	measure<54>();
+	measure<70>();
+	measure<128>();
+	measure<255>();
+	return 0;
+}
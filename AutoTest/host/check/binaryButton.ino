@@ -0,0 +1,25 @@
+/**
+ * @file binaryButton.ino
+ *
+ * Examples/button.ino in binary mode, for make check. The frames hold every byte value, also those of the stream
+ * requests, so a run with streamed test cases must give the same bytes as one with the test cases in Flash
+ */
+#include "AutomaticTesting.h"
+
+#define BUTTON	2
+#define LED		13
+
+void setup()
+{
+	Serial.begin(115200);
+	autotest.begin();
+	autotest.setOutputMode(AUTOTEST_OUTPUT_BINARY);
+
+	pinMode(BUTTON, INPUT_PULLUP);
+	pinMode(LED, OUTPUT);
+}
+void loop()
+{
+	digitalWrite(LED, digitalRead(BUTTON) == LOW);
+	delay(5);
+}
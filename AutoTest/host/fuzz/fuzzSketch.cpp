@@ -0,0 +1,464 @@
+/**
+ * @file fuzzSketch.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Coverage guided fuzzing of a sketch on the host build (make FUZZ=1). The input of a run is a byte buffer that is
+ * turned into packed test case records (see AutoTest::getPackedTestCase()): per test case one byte for the delay in
+ * steps of AUTOTEST_FUZZ_DELAY_STEP msec and two bytes per input pin. An input that has a value above 1 or a
+ * generator in TestCases.h of the test set is analog and gets 0 - 1023, the other inputs get LOW or HIGH.
+ *
+ * Between runs the sketch, AutoTest and the Arduino core are reset by copying back their variables as they were after
+ * setup(). The Makefile renames .data and .bss of the sketch and the core objects to autotest_state_data and
+ * autotest_state_bss, so a reset is two memcpy()s and the pin headers are not read again. Statics of inline
+ * functions and templates are not in these sections and are not reset. AddressSanitizer does not go with this reset,
+ * it would see the copy of its redzones between the variables.
+ *
+ * LLVMFuzzerTestOneInput() is the entry point for libFuzzer (make FUZZ=1 FUZZER=libfuzzer CXX=clang++). Without
+ * libFuzzer main() below is a small fuzzer of its own that uses the -fsanitize-coverage=trace-pc instrumentation of gcc
+ * and clang. It keeps the inputs that reach new code and changes them at random:
+ * \n NAME-fuzz [-n runs] [-s seed] [-o crash.h]	fuzzes, the input of a crash is written to crash.h as TestCases.h
+ * \n NAME-fuzz -t input						prints an input, like a crash file of libFuzzer, as TestCases.h
+ * \n NAME-fuzz -w input						writes the test set as an input, the seed for a libFuzzer corpus
+ * \n NAME-fuzz input...						runs the inputs with the trace of the sketch on stdout
+ *
+ * A crash is a signal: an assert() in the sketch that fails, a sanitizer or a bad pointer. TestCases.h of a crash
+ * replaces the one of the test set to run it in the normal host build or on the board.
+ */
+#include <Arduino.h>
+#include <AutoTest.h>
+#include <FieldLengths.h>
+
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <vector>
+
+#ifndef AUTOTEST_FUZZ_DELAY_STEP
+#define AUTOTEST_FUZZ_DELAY_STEP	4UL			// msec per step of the delay byte, so up to 1020 msec
+#endif
+#ifndef AUTOTEST_FUZZ_TEST_CASES
+#define AUTOTEST_FUZZ_TEST_CASES	32			// test cases per run, the rest of a longer input is not used
+#endif
+#ifndef AUTOTEST_FUZZ_SETTLE_TIME
+#define AUTOTEST_FUZZ_SETTLE_TIME	200UL		// msec the sketch keeps running after the last test case
+#endif
+#define FUZZ_RECORD_BYTES			(1 + 2 * NUMBER_OF_INPUT_PINS)
+#define FUZZ_RECORD_WORDS			AUTOTEST_PACKED_RECORD_WORDS(NUMBER_OF_INPUT_PINS)
+#define FUZZ_MAP_SIZE				16384		// edges in the coverage map, a power of 2
+
+extern AutoTestBase &autotestHost;				// defined in AutomaticTesting.h included by the sketch
+//
+// the variables of the sketch and the core, see the Makefile
+//
+extern char __start_autotest_state_data[], __stop_autotest_state_data[];
+extern char __start_autotest_state_bss[], __stop_autotest_state_bss[];
+
+static const char testSetCases[] =				// the test set, for the analog inputs and the seed
+#include <TestCases.h>
+;
+static const char			descriptions[] PROGMEM = "fuzz";
+static uint16_t				records[AUTOTEST_FUZZ_TEST_CASES * FUZZ_RECORD_WORDS];
+static bool					analogInput[NUMBER_OF_INPUT_PINS + 1];
+static std::vector<char>	dataSnapshot;		// autotest_state_data after setup()
+static std::vector<char>	bssSnapshot;		// autotest_state_bss after setup()
+
+/**
+ * @name decodeInput(const uint8_t *data, size_t size)
+ * @returns unsigned int	number of test cases in records
+ */
+static unsigned int decodeInput(const uint8_t *data, size_t size) {
+	unsigned int count = 0;
+
+	for (; size >= FUZZ_RECORD_BYTES && count < AUTOTEST_FUZZ_TEST_CASES; size -= FUZZ_RECORD_BYTES) {
+		uint16_t		*record = records + count++ * FUZZ_RECORD_WORDS;
+		unsigned long	delay = data[0] * AUTOTEST_FUZZ_DELAY_STEP;
+
+		record[0] = delay & 0xFFFF;
+		record[1] = delay >> 16;
+		record[2] = 0;
+		for (uint8_t i = 0; i < NUMBER_OF_INPUT_PINS; i++) {
+			uint16_t value = data[1 + 2 * i] | (data[2 + 2 * i] << 8);
+
+			record[3 + i] = analogInput[i] ? value % 1024 : value & 1;
+		}
+		data += FUZZ_RECORD_BYTES;
+	}
+	return count;
+}
+
+/**
+ * @name formatTestCases(const uint8_t *data, size_t size, char *text, size_t length)
+ * @returns size_t	length of the text
+ * Writes the test cases of an input as TestCases.h. No memory is allocated, this also runs in the signal handler
+ */
+static size_t formatTestCases(const uint8_t *data, size_t size, char *text, size_t length) {
+	unsigned int	count = decodeInput(data, size);
+	size_t			used;
+
+	used = snprintf(text, length, "/**\n * @file TestCases.h\n *\n * this is a generated file from a fuzz input by "
+					"fuzzSketch\n */\n\n#ifndef TESTCASES_H_\n#define TESTCASES_H_\n");
+	for (unsigned int n = 0; n < count && used < length; n++) {
+		const uint16_t *record = records + n * FUZZ_RECORD_WORDS;
+
+		used += snprintf(text + used, length - used, "\"fuzz %u", n);
+		for (uint8_t i = 0; i < NUMBER_OF_INPUT_PINS && used < length; i++) {
+			used += snprintf(text + used, length - used, ",%u", record[3 + i]);
+		}
+		if (used < length) {
+			used += snprintf(text + used, length - used, ",%lu\\n\"\n", record[0] | ((unsigned long)record[1] << 16));
+		}
+	}
+	if (used < length) {
+		used += snprintf(text + used, length - used, "\"\\n\"\n#endif // TESTCASES_H_\n");
+	}
+	return used < length ? used : length;
+}
+
+/**
+ * @name findAnalogInputs()
+ * An input is analog if the test set gives it a value above 1 or a generator
+ */
+static void findAnalogInputs() {
+	const char *ptr = testSetCases;
+
+	while (*ptr != '\n' && *ptr != '\0') {
+		ptr = strchr(ptr, ',');						// skip the description
+		for (uint8_t i = 0; i < NUMBER_OF_INPUT_PINS && ptr != NULL; i++) {
+			ptr++;
+			if ((*ptr >= 'A' && *ptr <= 'Z') || (*ptr >= 'a' && *ptr <= 'z') || atol(ptr) > 1) {
+				analogInput[i] = true;
+			}
+			ptr = strpbrk(ptr, ",\n");
+		}
+		if (ptr == NULL || (ptr = strchr(ptr, '\n')) == NULL) {
+			break;
+		}
+		ptr++;
+	}
+}
+
+/**
+ * @name seedInput()
+ * @returns std::vector<uint8_t>	the test cases of the test set as an input, delays above 255 steps are cut
+ */
+static std::vector<uint8_t> seedInput() {
+	std::vector<uint8_t>	input;
+	const char				*ptr = testSetCases;
+
+	while (*ptr != '\n' && *ptr != '\0' && (ptr = strchr(ptr, ',')) != NULL) {
+		std::vector<uint8_t> record(FUZZ_RECORD_BYTES, 0);
+
+		for (uint8_t i = 0; i < NUMBER_OF_INPUT_PINS && ptr != NULL; i++) {
+			unsigned long value = atol(ptr + 1);
+
+			record[1 + 2 * i] = value & 0xFF;
+			record[2 + 2 * i] = value >> 8;
+			ptr = strpbrk(ptr + 1, ",\n");
+		}
+		if (ptr != NULL && *ptr == ',') {
+			unsigned long steps = atol(ptr + 1) / AUTOTEST_FUZZ_DELAY_STEP;
+
+			record[0] = steps > 255 ? 255 : steps;
+		}
+		input.insert(input.end(), record.begin(), record.end());
+		if (ptr == NULL || (ptr = strchr(ptr, '\n')) == NULL) {
+			break;
+		}
+		ptr++;
+	}
+	return input;
+}
+
+/**
+ * @name prepare(bool quiet)
+ * Runs setup() once and takes the snapshot the runs start from. Quiet runs only send the verdict
+ */
+static void prepare(bool quiet) {
+	findAnalogInputs();
+	autotestHost.startPackedTestCases(records, descriptions, 0);
+	setup();
+	if (quiet) {
+		autotestHost.setOutputMode(AUTOTEST_OUTPUT_VERDICT);
+	}
+	Serial.flush();
+	dataSnapshot.assign(__start_autotest_state_data, __stop_autotest_state_data);
+	bssSnapshot.assign(__start_autotest_state_bss, __stop_autotest_state_bss);
+}
+
+/**
+ * @name runInput(const uint8_t *data, size_t size)
+ * Resets the sketch and runs it with the test cases of the input, like main.cpp does
+ */
+static void runInput(const uint8_t *data, size_t size) {
+	unsigned int	count = decodeInput(data, size);
+	unsigned long	endTime;
+
+	memcpy(__start_autotest_state_data, dataSnapshot.data(), dataSnapshot.size());
+	memcpy(__start_autotest_state_bss, bssSnapshot.data(), bssSnapshot.size());
+	autotestHost.startPackedTestCases(records, descriptions, count);
+	while (!autotestHost.testSetCompleted()) {
+		loop();
+		yield();
+		autotestHost.idle();
+	}
+	endTime = autotestHost.callMillis() + AUTOTEST_FUZZ_SETTLE_TIME;
+	while (autotestHost.callMillis() < endTime) {
+		loop();
+		yield();
+		autotestHost.idle();
+	}
+	autotestHost.finish();
+	while (autotestHost.flush()) {
+	}
+}
+
+#ifdef AUTOTEST_LIBFUZZER
+extern "C" int LLVMFuzzerInitialize(int *argc, char ***argv) {
+	(void)argc;
+	(void)argv;
+	prepare(true);
+	return 0;
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
+	runInput(data, size);
+	return 0;
+}
+#else
+static uint8_t				coverage[FUZZ_MAP_SIZE];	// hits of every edge in this run
+static uint8_t				seen[FUZZ_MAP_SIZE];		// classes of hit counts seen in all runs
+static uintptr_t			previousPc = 0;
+static std::vector<uint8_t>	current;					// input that runs now
+static const char			*crashFile = "crash.h";
+static char					crashText[65536];			// TestCases.h of the crash
+
+/**
+ * @name __sanitizer_cov_trace_pc()
+ * Called by -fsanitize-coverage=trace-pc at every edge of the sketch, the only code that is instrumented
+ */
+extern "C" void __sanitizer_cov_trace_pc() {
+	uintptr_t pc = (uintptr_t)__builtin_return_address(0);
+	uint8_t &hits = coverage[(pc ^ previousPc) & (FUZZ_MAP_SIZE - 1)];
+
+	if (hits != 255) {
+		hits++;
+	}
+	previousPc = pc >> 1;
+}
+
+/**
+ * @name newCoverage()
+ * @returns bool	true if the run reached an edge, or an edge a number of times, no run did before
+ * Hit counts are taken in classes 1, 2, 3, 4-7, 8-15, 16-31, 32-127 and 128 or more
+ */
+static bool newCoverage() {
+	static const uint8_t	classes[] = { 1, 2, 4, 8, 8, 8, 8, 16, 16, 16, 16, 16, 16, 16, 16 };
+	uint64_t				*words = (uint64_t *)coverage;
+	bool					found = false;
+
+	for (size_t w = 0; w < FUZZ_MAP_SIZE / 8; w++) {
+		if (words[w] == 0) {
+			continue;
+		}
+		for (size_t i = w * 8; i < w * 8 + 8; i++) {
+			uint8_t hits = coverage[i];
+			uint8_t hitClass = hits == 0 ? 0 : hits < 16 ? classes[hits - 1] : hits < 32 ? 32 : hits < 128 ? 64 : 128;
+
+			if (hitClass & ~seen[i]) {
+				seen[i] |= hitClass;
+				found = true;
+			}
+		}
+		words[w] = 0;
+	}
+	previousPc = 0;
+	return found;
+}
+
+/**
+ * @name mutate(std::vector<uint8_t> &input)
+ * Changes a few bytes or test cases of the input at random
+ */
+static void mutate(std::vector<uint8_t> &input) {
+	int changes = 1 + rand() % 4;
+
+	while (changes-- > 0) {
+		size_t records = input.size() / FUZZ_RECORD_BYTES;
+		size_t record = records > 0 ? rand() % records * FUZZ_RECORD_BYTES : 0;
+
+		switch (records == 0 ? 3 : rand() % 6) {
+		case 0:											// flip a bit
+			input[rand() % input.size()] ^= 1 << (rand() % 8);
+			break;
+		case 1:											// another value or delay
+			input[rand() % input.size()] = rand();
+			break;
+		case 2:											// toggle a digital input
+			input[record + 1 + 2 * (rand() % (FUZZ_RECORD_BYTES / 2))] ^= 1;
+			break;
+		case 3:											// a new test case
+			if (records < AUTOTEST_FUZZ_TEST_CASES) {
+				for (size_t i = 0; i < FUZZ_RECORD_BYTES; i++) {
+					input.insert(input.begin() + record, (uint8_t)rand());
+				}
+			}
+			break;
+		case 4:											// one test case less
+			if (records > 1) {
+				input.erase(input.begin() + record, input.begin() + record + FUZZ_RECORD_BYTES);
+			}
+			break;
+		case 5:											// a test case twice
+			if (records < AUTOTEST_FUZZ_TEST_CASES) {
+				std::vector<uint8_t> copy(input.begin() + record, input.begin() + record + FUZZ_RECORD_BYTES);
+
+				input.insert(input.begin() + record, copy.begin(), copy.end());
+			}
+			break;
+		}
+	}
+}
+
+/**
+ * @name crashed(int number)
+ * Writes the input that crashed as TestCases.h and lets the signal end the program
+ */
+static void crashed(int number) {
+	size_t	length = formatTestCases(current.data(), current.size(), crashText, sizeof(crashText));
+	int		file = open(crashFile, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	ssize_t	written = -1;
+
+	if (file >= 0) {
+		written = write(file, crashText, length);
+		close(file);
+	}
+	fprintf(stderr, "\nsignal %d, %s %s\n", number, written == (ssize_t)length ? "the input is in" : "cannot write",
+			crashFile);
+	signal(number, SIG_DFL);
+	raise(number);
+}
+
+/**
+ * @name readInput(const char *path, std::vector<uint8_t> &input)
+ * @returns bool	false if the file cannot be read
+ */
+static bool readInput(const char *path, std::vector<uint8_t> &input) {
+	FILE	*file = fopen(path, "rb");
+	int		c;
+
+	if (file == NULL) {
+		return false;
+	}
+	input.clear();
+	while ((c = getc(file)) != EOF) {
+		input.push_back(c);
+	}
+	fclose(file);
+	return true;
+}
+
+int main(int argc, char **argv) {
+	unsigned long			runs = 100000;		// runs of the fuzzer
+	unsigned int			seed = time(NULL);
+	std::vector<uint8_t>	input;
+	int						arg = 1;
+
+	for (; arg + 1 < argc && argv[arg][0] == '-' && strlen(argv[arg]) == 2; arg += 2) {
+		switch (argv[arg][1]) {
+		case 'n':
+			runs = strtoul(argv[arg + 1], NULL, 0);
+			break;
+		case 's':
+			seed = strtoul(argv[arg + 1], NULL, 0);
+			break;
+		case 'o':
+			crashFile = argv[arg + 1];
+			break;
+		case 't':
+			if (!readInput(argv[arg + 1], input)) {
+				perror(argv[arg + 1]);
+				return 2;
+			}
+			findAnalogInputs();
+			fwrite(crashText, 1, formatTestCases(input.data(), input.size(), crashText, sizeof(crashText)), stdout);
+			return 0;
+		case 'w': {
+			FILE *file = fopen(argv[arg + 1], "wb");
+
+			input = seedInput();
+			if (file == NULL || fwrite(input.data(), 1, input.size(), file) != input.size()) {
+				perror(argv[arg + 1]);
+				return 2;
+			}
+			fclose(file);
+			return 0;
+		}
+		default:
+			arg = argc;
+			break;
+		}
+	}
+	if (arg < argc && argv[arg][0] == '-') {
+		fprintf(stderr, "usage: %s [-n runs] [-s seed] [-o crash.h] | -t input | -w input | input...\n", argv[0]);
+		return 2;
+	}
+	//
+	// run the inputs given
+	//
+	if (arg < argc) {
+		prepare(false);
+		for (; arg < argc; arg++) {
+			if (!readInput(argv[arg], current)) {
+				perror(argv[arg]);
+				return 2;
+			}
+			runInput(current.data(), current.size());
+			Serial.println();
+			Serial.flush();
+		}
+		return 0;
+	}
+	//
+	// or fuzz, starting with the test set. The sketch prints nothing while it is fuzzed
+	//
+	std::vector<std::vector<uint8_t> >	corpus(1, seedInput());
+	struct timespec						start, end;
+	unsigned long						edges = 0;
+
+	srand(seed);
+	if (freopen("/dev/null", "w", stdout) == NULL) {
+		perror("/dev/null");
+		return 2;
+	}
+	prepare(true);
+	signal(SIGABRT, crashed);
+	signal(SIGSEGV, crashed);
+	signal(SIGFPE, crashed);
+	signal(SIGBUS, crashed);
+	signal(SIGILL, crashed);
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	for (unsigned long run = 0; run < runs; run++) {
+		current = corpus[run == 0 ? 0 : rand() % corpus.size()];
+		if (run > 0) {
+			mutate(current);
+		}
+		runInput(current.data(), current.size());
+		if (newCoverage() && run > 0) {
+			corpus.push_back(current);
+		}
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	for (size_t i = 0; i < FUZZ_MAP_SIZE; i++) {
+		edges += seen[i] != 0;
+	}
+	double seconds = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+	fprintf(stderr, "%lu runs in %.1f sec, %.0f runs/sec, seed %u, %lu edges, %zu inputs in the corpus, no crash\n",
+			runs, seconds, runs / seconds, seed, edges, corpus.size());
+	return 0;
+}
+#endif
@@ -0,0 +1,309 @@
+/**
+ * @file main.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * main() for the host build. It does what the Arduino core does on the board: call setup() once and
+ * then loop() over and over again. As a program on the host has to stop at some point, loop() is called until
+ * AutoTest has activated the last test case and after that for AUTOTEST_HOST_SETTLE_TIME milliseconds so the
+ * sketch can respond to the last test case.
+ *
+ * After every pass through loop() AutoTest is told so the virtual clock can move on when the sketch was idle.
+ *
+ * The exit code is 1 if a test case did not have its expected output values.
+ *
+ * Built with AUTOTEST_HOST_TEST_SET_FILES (make FILES=1) the test set folder is the argument of the program. With
+ * more folders, test sets for the same pins that start with the same test cases share the run of those test cases.
+ * They are run in sorted order as a prefix tree: after every activation a checkpoint is saved (saveState()) for as long
+ * as the test set that runs next has the same test cases. That one restores the deepest checkpoint it can use and
+ * only runs the test cases after it. The output of each test set starts with TESTSET and its folder and continues
+ * where the checkpoint was saved. The variables of the sketch are only part of the checkpoints if it registers them
+ * with registerState(), the random() sequence of the core is not. A sketch that registers nothing in setup() would
+ * carry its variables over from one test set to the next, so then every test set runs from setup() in a process of
+ * its own instead.
+ */
+#include <Arduino.h>
+#include <AutoTest.h>
+
+#ifndef AUTOTEST_HOST_SETTLE_TIME
+#define AUTOTEST_HOST_SETTLE_TIME	1000UL		// time in msec the sketch keeps running after the last test case
+#endif
+
+extern AutoTestBase &autotestHost;				// defined in AutomaticTesting.h included by the sketch
+/**
+ * @name runSketch()
+ * @returns int		exit code: 1 if a test case did not have its expected output values, otherwise 0
+ * Calls loop() until AutoTest has activated the last test case and for AUTOTEST_HOST_SETTLE_TIME after that. setup()
+ * must have been called
+ */
+static int runSketch() {
+	unsigned long endTime;						// moment the sketch is stopped
+
+	//
+	// run until all the test cases are activated
+	//
+	while (!autotestHost.testSetCompleted()) {
+		loop();
+		yield();
+		autotestHost.idle();
+	}
+	//
+	// and give the sketch some time to respond to the last one
+	//
+	endTime = autotestHost.callMillis() + AUTOTEST_HOST_SETTLE_TIME;
+	while (autotestHost.callMillis() < endTime) {
+		loop();
+		yield();
+		autotestHost.idle();
+	}
+	//
+	// send what is left in the trace buffer and the response times if they were measured
+	//
+	autotestHost.finish();
+	while (autotestHost.flush()) {
+	}
+	autotestHost.printLatencyStats();
+	Serial.println();
+	Serial.flush();
+	//
+	// a test case without its expected values fails the run
+	//
+	return autotestHost.failedTestCases() == 0 ? 0 : 1;
+}
+
+#ifdef AUTOTEST_HOST_TEST_SET_FILES
+#include <AutoTestHost.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <algorithm>
+
+#define AUTOTEST_HOST_RUN_ALONE		4			// added to the exit code of runTree() if the others must run alone
+
+extern AutoTestHost &autotestHostFiles;			// the same object, to load the test set
+
+/**
+ * a test set run by runTestSetTree()
+ */
+struct TestSetRun {
+	const char				*folder;
+	std::string				records;			// CSV of its TestCases.h
+	std::vector<size_t>		starts;				// offset of each test case in records and of the empty line after them
+};
+
+/**
+ * state of the sketch just before a pass through loop()
+ */
+struct Checkpoint {
+	int						pending;			// test case activated next, it is the same for who uses the checkpoint
+	size_t					run;				// test set that saved it
+	std::vector<uint8_t>	state;
+};
+
+/**
+ * @name sharedTestCases(const TestSetRun &a, const TestSetRun &b)
+ * @returns size_t	number of test cases both test sets start with
+ */
+static size_t sharedTestCases(const TestSetRun &a, const TestSetRun &b) {
+	size_t shared = 0;
+
+	while (shared + 1 < a.starts.size() && shared + 1 < b.starts.size() &&
+		   a.records.compare(a.starts[shared], a.starts[shared + 1] - a.starts[shared], b.records, b.starts[shared],
+							 b.starts[shared + 1] - b.starts[shared]) == 0) {
+		shared++;
+	}
+	return shared;
+}
+
+/**
+ * @name runTree(std::vector<TestSetRun> &runs, const std::vector<size_t> &order)
+ * @returns int		exit code: 2 if a test set could not run, 1 if a test case failed, otherwise 0. If the sketch did
+ * not register its variables in setup() only the first test set is run and AUTOTEST_HOST_RUN_ALONE is added.
+ * The first test set in order must be loaded
+ */
+static int runTree(std::vector<TestSetRun> &runs, const std::vector<size_t> &order) {
+	std::vector<Checkpoint>	checkpoints;		// a stack, deepest checkpoint last
+	uint8_t					ownBlocks = autotestHost.stateBlockCount();	// blocks of AutoTest and the core
+	int						result = 0;
+
+	for (size_t i = 0; i < order.size(); i++) {
+		TestSetRun		&run = runs[order[i]];
+		size_t			shared = i + 1 < order.size() ? sharedTestCases(run, runs[order[i + 1]]) : 0;
+		unsigned long	endTime;
+
+		if (i > 0) {
+			//
+			// continue from the deepest checkpoint that has the same test cases up to the pending one
+			//
+			while (!checkpoints.empty() &&
+				   (size_t)checkpoints.back().pending >= sharedTestCases(runs[checkpoints.back().run], run)) {
+				checkpoints.pop_back();
+			}
+			if (checkpoints.empty() || !autotestHost.restoreState(checkpoints.back().state.data())) {
+				fprintf(stderr, "%s does not start like %s, run it on its own\n", run.folder, runs[order[0]].folder);
+				result = 2;
+				continue;
+			}
+			autotestHost.continueTestCases(run.records.c_str() + run.starts[checkpoints.back().pending + 1]);
+		}
+		Serial.print("\r\nTESTSET" CSV_SEPARATOR);
+		Serial.println(run.folder);
+		if (i == 0) {
+			setup();
+			//
+			// without the variables of the sketch a checkpoint would not bring it back where it was
+			//
+			if (autotestHost.stateBlockCount() == ownBlocks) {
+				return runSketch() + AUTOTEST_HOST_RUN_ALONE;
+			}
+		}
+		while (!autotestHost.testSetCompleted()) {
+			int pending = autotestHost.pendingTestCase();
+
+			if (pending >= 0 && (size_t)pending < shared &&
+				(checkpoints.empty() || pending > checkpoints.back().pending)) {
+				checkpoints.push_back(Checkpoint());
+				checkpoints.back().pending = pending;
+				checkpoints.back().run = order[i];
+				checkpoints.back().state.resize(autotestHost.stateSize());
+				autotestHost.saveState(checkpoints.back().state.data());
+			}
+			loop();
+			yield();
+			autotestHost.idle();
+		}
+		endTime = autotestHost.callMillis() + AUTOTEST_HOST_SETTLE_TIME;
+		while (autotestHost.callMillis() < endTime) {
+			loop();
+			yield();
+			autotestHost.idle();
+		}
+		autotestHost.finish();
+		while (autotestHost.flush()) {
+		}
+		autotestHost.printLatencyStats();
+		Serial.println();
+		Serial.flush();
+		if (result == 0 && autotestHost.failedTestCases() != 0) {
+			result = 1;
+		}
+	}
+	return result;
+}
+
+/**
+ * @name runInChild(Run run)
+ * @returns int		exit code of run(), 2 if the process could not be started
+ * Runs the sketch in a child process. This process never runs the sketch, so every child starts with the variables
+ * of the sketch as they were before setup()
+ */
+template <typename Run> static int runInChild(Run run) {
+	pid_t	pid;
+	int		status;
+
+	fflush(stdout);
+	pid = fork();
+	if (pid == 0) {
+		exit(run());
+	}
+	if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status)) {
+		return 2;
+	}
+	return WEXITSTATUS(status);
+}
+
+/**
+ * @name runAlone(const char *folder)
+ * @returns int		exit code: 2 if the test set cannot be loaded, 1 if a test case failed, otherwise 0
+ * Runs the test set in folder from setup(), with TESTSET in front of its output like in a tree
+ */
+static int runAlone(const char *folder) {
+	std::string error;
+
+	if (!autotestHostFiles.load(folder, error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 2;
+	}
+	Serial.print("\r\nTESTSET" CSV_SEPARATOR);
+	Serial.println(folder);
+	setup();
+	return runSketch();
+}
+
+/**
+ * @name runTestSetTree(int count, char **folders)
+ * @returns int		exit code: 2 if a test set could not run, 1 if a test case failed, otherwise 0
+ */
+static int runTestSetTree(int count, char **folders) {
+	std::vector<TestSetRun>	runs(count);
+	std::vector<size_t>		order;				// runs sorted on their test cases, so shared ones are next to each other
+	std::string				error;
+	int						result;
+
+	if (!autotestHostFiles.load(folders[0], error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 2;
+	}
+	for (int i = 0; i < count; i++) {
+		runs[i].folder = folders[i];
+		if (!autotestHostFiles.loadTestCases(folders[i], runs[i].records, error)) {
+			fprintf(stderr, "%s\n", error.c_str());
+			return 2;
+		}
+		for (size_t start = 0; start < runs[i].records.size(); start = runs[i].records.find('\n', start) + 1) {
+			runs[i].starts.push_back(start);
+			if (runs[i].records[start] == '\n') {
+				break;
+			}
+		}
+		order.push_back(i);
+	}
+	std::sort(order.begin(), order.end(), [&runs](size_t a, size_t b) { return runs[a].records < runs[b].records; });
+	//
+	// the first one starts from setup(), with its own test cases
+	//
+	if (order[0] != 0 && !autotestHostFiles.load(folders[order[0]], error)) {
+		fprintf(stderr, "%s\n", error.c_str());
+		return 2;
+	}
+	autotestHost.registerState((void *)hostRegisters, sizeof(hostRegisters));
+	result = runInChild([&runs, &order]() { return runTree(runs, order); });
+	if (result < AUTOTEST_HOST_RUN_ALONE) {
+		return result;
+	}
+	//
+	// the sketch has no checkpoints, so the others start from setup() as well
+	//
+	result -= AUTOTEST_HOST_RUN_ALONE;
+	for (size_t i = 1; i < order.size(); i++) {
+		const char *folder = runs[order[i]].folder;
+
+		result = std::max(result, runInChild([folder]() { return runAlone(folder); }));
+	}
+	return result;
+}
+#endif
+
+int main(int argc, char **argv) {
+#ifdef AUTOTEST_HOST_TEST_SET_FILES
+	std::string error;							// why the test set cannot be loaded
+
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s testSetFolder...\n", argv[0]);
+		return 2;
+	}
+	if (argc > 2) {
+		return runTestSetTree(argc - 1, argv + 1);
+	}
+	if (!autotestHostFiles.load(argv[1], error)) {
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 2;
+	}
+#else
+	(void)argc;
+	(void)argv;
+#endif
+	setup();
+	return runSketch();
+}
@@ -0,0 +1,16 @@
+/**
+ * @file FieldLengths.h
+ * 
+ * this is a generated file from generateTestSets.xls
+ */
+
+#ifndef FIELD_LENGTHS_H_ 
+#define FIELD_LENGTHS_H_ 
+
+#define NUMBER_OF_PINS 2
+
+#define NUMBER_OF_INPUT_PINS 1
+#define MAX_FIELD_LENGTH 7
+#define MAX_DESCRIPTION_LENGTH 16
+
+#endif  // FIELD_LENGTHS_H_
@@ -0,0 +1,16 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from generateTestSets.xls
+ * It contains all the testcases generated from the sheet
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Button released,0,0\n"
+"Button pressed,1,1200\n" // press after the second blink
+"Button released,0,800\n"
+"Short press,1,300\n"
+"Button released,0,100\n"
+"\n"
+#endif // TESTCASES_H_ 
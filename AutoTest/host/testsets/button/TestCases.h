@@ -0,0 +1,16 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Button released,1,0,0,10,0\n"
+"Button pressed,0,500,0,10,1\n"
+"Button released,1,500,0,10,0\n"
+"Short press,0,200,5,10,1\n"
+"Button released,1,20,0,10,0\n"
+"\n"
+#endif // TESTCASES_H_
@@ -0,0 +1,16 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Running,1,0,0,10,1,0,x\n"
+"Short overload,0,1000,30,40,1,0,x\n"
+"Overload over,1,30,0,10,1,0,x\n"
+"Long overload,0,1000,45,70,0,1,x\n"
+"Overload over,1,200,0,10,0,1,x\n"
+"\n"
+#endif // TESTCASES_H_
@@ -0,0 +1,13 @@
+/**
+ * @file PinHeaders.h
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the used pins and definitions used
+ */
+#ifndef PINHEADERS_H_
+#define PINHEADERS_H_
+"2,OVERLOAD\n"
+"9,MOTOR\n"
+"12,FAULT\n"
+"13,HEARTBEAT\n"
+"\n"
+#endif // PINHEADERS_H_
@@ -0,0 +1,19 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Released,1,0,0,5,0\n"
+"Pressed,0,300,0,5,1\n"
+"Released,1,200,0,5,1\n"
+"Pressed again,0,200,0,5,0\n"
+"Released again,1,200,0,5,0\n"
+"Short press,0,1500,0,5,1\n"
+"Short release,1,2,0,5,1\n"
+"Done,1,1000\n"
+"\n"
+#endif // TESTCASES_H_
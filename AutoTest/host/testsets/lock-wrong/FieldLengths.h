@@ -0,0 +1,18 @@
+/**
+ * @file FieldLengths.h
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ */
+
+#ifndef FIELD_LENGTHS_H_ 
+#define FIELD_LENGTHS_H_ 
+
+#define NUMBER_OF_PINS 2
+
+#define NUMBER_OF_INPUT_PINS 1
+#define MAX_FIELD_LENGTH 7
+#define MAX_DESCRIPTION_LENGTH 13
+#define MAX_EXPECTED_VALUES 1
+#define NUMBER_OF_ANALOG_PINS 0
+
+#endif  // FIELD_LENGTHS_H_
@@ -0,0 +1,21 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Released,1,0,0,10,0\n"
+"Short,0,1500,0,10,0\n"
+"Released,1,100,0,10,0\n"
+"Long,0,200,0,10,0\n"
+"Released,1,500,0,10,0\n"
+"Long again,0,200,0,10,0\n"
+"Released,1,500,0,10,0\n"
+"Long instead,0,200,0,10,0\n"
+"Stays closed,1,500,0,10,0\n"
+"Still closed,1,1500,0,10,0\n"
+"\n"
+#endif // TESTCASES_H_
@@ -0,0 +1,19 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Released,1,0,0,10,0,0,0,0\n"
+"Press 1,0,100,0,10,1,0,0,0\n"
+"Release,1,100,0,10,1,0,0,0\n"
+"Press 2,0,100,0,10,0,1,0,0\n"
+"Release,1,100\n"
+"Press 3,0,100,0,10,1,1,0,0\n"
+"Release,1,100\n"
+"Press 4,0,100,0,10,0,0,1,0\n"
+"\n"
+#endif // TESTCASES_H_
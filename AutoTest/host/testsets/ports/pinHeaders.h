@@ -0,0 +1,14 @@
+/**
+ * @file PinHeaders.h
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the used pins and definitions used
+ */
+#ifndef PINHEADERS_H_
+#define PINHEADERS_H_
+"2,BUTTON\n"
+"8,LED0\n"
+"9,LED1\n"
+"10,LED2\n"
+"11,LED3\n"
+"\n"
+#endif // PINHEADERS_H_
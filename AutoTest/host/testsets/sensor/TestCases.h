@@ -0,0 +1,21 @@
+/**
+ * @file TestCases.h 
+ * 
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the testcases of the test set
+ */
+
+#ifndef TESTCASES_H_ 
+#define TESTCASES_H_ 
+"Low,100,0,0,10,0\n"
+"Ramp up,r0:1023:1000,200,700,1000,1\n"
+"Noise above OFF,n500:90:7,1200,0,400,1\n"
+"Ramp down,r1023:0:1000,500,700,1000,0\n"
+"Noise below ON,n500:90:11,1200,0,400,0\n"
+"Step up,t0:800:300,500,0,250,0\n"
+"Step is seen,800,600,0,10,1\n"
+"Slow sine,s512:400:2000,200,200,450,1\n"
+"Sine low half,s512:400:2000,2000,1200,1450,0\n"
+"Done,0,2000\n"
+"\n"
+#endif // TESTCASES_H_
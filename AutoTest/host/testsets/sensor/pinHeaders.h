@@ -0,0 +1,11 @@
+/**
+ * @file PinHeaders.h
+ * this is a generated file from testSet.csv by generateTestSet
+ * It contains all the used pins and definitions used
+ */
+#ifndef PINHEADERS_H_
+#define PINHEADERS_H_
+"14,SENSOR\n"
+"13,LED\n"
+"\n"
+#endif // PINHEADERS_H_
@@ -0,0 +1,499 @@
+/**
+ * @file decodeTrace.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Turns the binary frames AutoTest sends in AUTOTEST_OUTPUT_BINARY mode and the delta records of AUTOTEST_OUTPUT_DELTA
+ * back into the CSV of AUTOTEST_OUTPUT_CSV so the existing spreadsheets keep working. The pin names and test case
+ * descriptions are not in the frames, they come from the generated headers of the test set.
+ * For delta records the full snapshot of all pins is rebuilt, starting at the first keyframe.
+ *
+ * usage: decodeTrace [-m | -u | -v [-a pin,...]] pinHeaders.h TestCases.h < trace > trace.csv
+ * \n -m	adds the time stamp in msec as the last field (like extendSerialOut in the blink example)
+ * \n -u	adds the time stamp in usec as the last field
+ * \n -v	writes a value change dump (VCD) for a waveform viewer instead of CSV. Each pin is a signal with its name
+ * from pinHeaders.h, testcase holds the number of the active test case and the activations, passes and fails are
+ * comments. Only the changes are written, with the time stamp in usec
+ * \n -a	pins, by name, that are dumped with 16 bits instead of 1 (analog pins)
+ *
+ * Bytes that are not part of a valid frame or record (text printed by the sketch itself) are skipped. The trace is
+ * read in blocks, so memory does not grow with its length.
+ */
+#include "headerFiles.h"
+#include "AutoTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+static std::vector<PinHeader>	pins;				// pins of the test set
+static std::vector<TestCase>	testCases;			// test cases of the test set
+static std::vector<uint16_t>	pinValues;			// current value of every pin
+static char						timeField = 0;		// 'm' or 'u' if the time stamp is added
+static unsigned long long		lastTime = 0;		// time stamp of the previous frame without wrap around
+static bool						keyframeSeen = false;	// delta records can only be used after a keyframe
+static unsigned long long		activationTime = 0;	// time stamp of the last test case activation
+static unsigned long long		previousTime = 0;	// time stamp of the frame or record before this one
+static unsigned long			testsPassed = 0;	// number of AUTOTEST_EVENT_PASS
+static bool						vcd = false;		// write a value change dump instead of CSV (-v)
+static std::vector<bool>		analogPins;			// pins dumped with 16 bits (-a)
+static std::vector<bool>		analogWarned;		// a 1 bit pin had a value other than 0 or 1
+static std::vector<uint16_t>	dumpedValues;		// value of every pin in the dump
+static bool						dumpStarted = false;	// the initial values are written
+static unsigned long long		dumpTime = 0;		// last time stamp written to the dump
+
+/**
+ * @name pinName(uint8_t index)
+ * @returns const char *	name of the pin with this index in pinHeaders.h
+ */
+static const char *pinName(uint8_t index) {
+	return index < pins.size() ? pins[index].name.c_str() : "?";
+}
+
+/**
+ * @name displayPins(const std::string &actionText)
+ * Same output as AutoTest::displayPins()
+ */
+static void displayPins(const std::string &actionText) {
+	printf("\r\n%s" CSV_SEPARATOR, actionText.c_str());
+	for (size_t i = 0; i < pinValues.size(); i++) {
+		printf("%u" CSV_SEPARATOR, pinValues[i]);
+	}
+	if (timeField == 'm') {
+		printf("%llu", lastTime / 1000ULL);
+	} else if (timeField == 'u') {
+		printf("%llu", lastTime);
+	}
+}
+
+/**
+ * @name setTime(unsigned long time)
+ * @param time	32 bit time stamp in usec from a frame or keyframe
+ * The time stamp wraps around after 71 minutes. lastTime keeps counting
+ */
+static void setTime(unsigned long time) {
+	previousTime = lastTime;
+	if (time < (lastTime & 0xFFFFFFFFULL)) {
+		lastTime += 0x100000000ULL;
+	}
+	lastTime = (lastTime & ~0xFFFFFFFFULL) | time;
+}
+
+/**
+ * @name updatePins(uint8_t type, uint8_t pin, unsigned long value)
+ * Sets the value of the pin of an event that changes it
+ */
+static void updatePins(uint8_t type, uint8_t pin, unsigned long value) {
+	if (pin >= pinValues.size()) {
+		return;
+	}
+	switch (type) {
+	case AUTOTEST_EVENT_READ:							// a generator changes the pin at the read
+	case AUTOTEST_EVENT_WRITE:
+	case AUTOTEST_EVENT_ANALOG_WRITE:
+	case AUTOTEST_EVENT_INPUT:
+	case AUTOTEST_EVENT_PORT_PIN:
+		pinValues[pin] = value;
+		break;
+	case AUTOTEST_EVENT_PIN_MODE:
+		pinValues[pin] = value == INPUT_PULLUP ? HIGH : LOW;
+		break;
+	}
+}
+
+/**
+ * @name decodeEvent(uint8_t type, uint8_t pin, unsigned long value)
+ * Prints what AutoTest would have printed in CSV mode
+ */
+static void decodeEvent(uint8_t type, uint8_t pin, unsigned long value) {
+	char text[64];
+
+	switch (type) {
+	case AUTOTEST_EVENT_READ:
+		displayPins(std::string("pin ") + pinName(pin) + " read");
+		break;
+	case AUTOTEST_EVENT_WRITE:
+		displayPins(std::string("pin ") + pinName(pin) + (value == LOW ? " set to LOW" : " set to HIGH"));
+		break;
+	case AUTOTEST_EVENT_ANALOG_WRITE:
+		displayPins(std::string("pin ") + pinName(pin) + " set to " + std::to_string(value));
+		break;
+	case AUTOTEST_EVENT_INTERRUPT:
+		displayPins(std::string("pin ") + pinName(pin) + " interrupt");
+		break;
+	case AUTOTEST_EVENT_INVALID_INTERRUPT:
+		printf("\r\nattachInterrupt(%u) invalid interrupt\r\n", pin);
+		break;
+	case AUTOTEST_EVENT_PORT_WRITE:
+		displayPins(std::string("port ") + (char)('A' + pin - 1) + " set to " + std::to_string(value));
+		break;
+	case AUTOTEST_EVENT_PORT_READ:
+		displayPins(std::string("port ") + (char)('A' + pin - 1) + " read");
+		break;
+	case AUTOTEST_EVENT_ACTIVATE:
+		displayPins(value < testCases.size() ? testCases[value].description : "test case " + std::to_string(value));
+		break;
+	case AUTOTEST_EVENT_INVALID_PIN_MODE:
+		snprintf(text, sizeof(text), "pinMode (%u,%lu) invalid pin", pin, value);
+		printf("\r\n%s\r\n", text);
+		break;
+	case AUTOTEST_EVENT_INVALID_READ:
+		printf("\r\ndigitalRead(%u) invalid pin\r\n", pin);
+		break;
+	case AUTOTEST_EVENT_INVALID_ANALOG_READ:
+		printf("\r\nanalogRead(%u) invalid pin\r\n", pin);
+		break;
+	case AUTOTEST_EVENT_INVALID_WRITE:
+	case AUTOTEST_EVENT_INVALID_ANALOG_WRITE:
+		printf("\r\ndigitalWrite(%u,%lu) invalid pin\r\n", pin, value);
+		break;
+	case AUTOTEST_EVENT_INVALID_VALUE:
+		printf("\r\ndigitalWrite(%u,%lu) error. Value sent is not HIGH or LOW\r\n", pin, value);
+		break;
+	case AUTOTEST_EVENT_PASS:
+	case AUTOTEST_EVENT_FAIL:
+		testsPassed += type == AUTOTEST_EVENT_PASS;
+		printf("\r\n%s" CSV_SEPARATOR "%lu" CSV_SEPARATOR "%s", type == AUTOTEST_EVENT_PASS ? "PASS" : "FAIL", value,
+			   value < testCases.size() ? testCases[value].description.c_str() : "");
+		break;
+	case AUTOTEST_EVENT_MISMATCH:
+		printf("\r\npin %s expected %lu got %lu", pinName(pin), value >> 16, value & 0xFFFF);
+		break;
+	case AUTOTEST_EVENT_RESULT:
+		printf("\r\nRESULT" CSV_SEPARATOR "%lu" CSV_SEPARATOR "%lu\r\n", testsPassed, value);
+		break;
+	case AUTOTEST_EVENT_READ_REPEAT:
+		//
+		// the record before is the read that was repeated
+		//
+		printf("\r\npin %s read %lu more times over %llu usec\r\n", pinName(pin), value, lastTime - previousTime);
+		break;
+	case AUTOTEST_EVENT_LATENCY:
+		printf("\r\npin %s responded after %lu usec\r\n", pinName(pin), value);
+		break;
+	case AUTOTEST_EVENT_DROPPED:
+		printf("\r\ntrace buffer full, %lu records dropped\r\n", value);
+		break;
+	case AUTOTEST_EVENT_TRIGGER:
+		printf("\r\ntrigger, %lu earlier events not sent\r\n", value);
+		break;
+	case AUTOTEST_EVENT_ANALOG_FULL:
+		printf("\r\npin %s value %lu set to HIGH, no AUTOTEST_ANALOG_PINS left\r\n", pinName(pin), value);
+		break;
+	}
+}
+
+/**
+ * @name vcdIdentifier(size_t signal)
+ * @returns std::string	short code of the signal in the dump, printable characters from ! to ~
+ */
+static std::string vcdIdentifier(size_t signal) {
+	std::string code;
+
+	do {
+		code += (char)('!' + signal % 94);
+		signal /= 94;
+	} while (signal > 0);
+	return code;
+}
+
+/**
+ * @name vcdBinary(unsigned long value)
+ * @returns std::string	value as a binary number without leading zeros
+ */
+static std::string vcdBinary(unsigned long value) {
+	std::string bits;
+
+	do {
+		bits.insert(bits.begin(), (char)('0' + (value & 1)));
+		value >>= 1;
+	} while (value > 0);
+	return bits;
+}
+
+/**
+ * @name vcdName(const std::string &name)
+ * @returns std::string	name without the spaces a waveform viewer does not accept
+ */
+static std::string vcdName(const std::string &name) {
+	std::string result = name;
+
+	for (size_t i = 0; i < result.size(); i++) {
+		if (result[i] <= ' ' || result[i] > '~') {
+			result[i] = '_';
+		}
+	}
+	return result;
+}
+
+/**
+ * @name vcdHeader()
+ * Declares a signal per pin, 1 bit or 16 bits for the pins of -a, and the number of the active test case
+ */
+static void vcdHeader() {
+	printf("$version AutoTest decodeTrace $end\n$timescale 1us $end\n$scope module autotest $end\n");
+	for (size_t i = 0; i < pins.size(); i++) {
+		printf("$var wire %d %s %s $end\n", analogPins[i] ? 16 : 1, vcdIdentifier(i).c_str(),
+			   vcdName(pins[i].name).c_str());
+	}
+	printf("$var integer 16 %s testcase $end\n$upscope $end\n$enddefinitions $end\n",
+		   vcdIdentifier(pins.size()).c_str());
+}
+
+/**
+ * @name vcdEvent(uint8_t type, unsigned long value)
+ * Writes the pins that changed since the last event with the time stamp. The first event also writes the values
+ * of all the pins. Test case activations change testcase and, like the results, are added as a comment
+ */
+static void vcdEvent(uint8_t type, unsigned long value) {
+	std::string changes;								// value changes at this time stamp
+
+	for (size_t i = 0; i < pinValues.size(); i++) {
+		uint16_t value = analogPins[i] ? pinValues[i] : pinValues[i] != 0;	// the value as it is dumped
+
+		if (pinValues[i] > 1 && !analogPins[i] && !analogWarned[i]) {
+			analogWarned[i] = true;
+			fprintf(stderr, "pin %s has value %u, dumped as 1. Use -a %s to see the value\n", pinName(i),
+					pinValues[i], pinName(i));
+		}
+		if (dumpStarted && dumpedValues[i] == value) {
+			continue;
+		}
+		dumpedValues[i] = value;
+		if (analogPins[i]) {
+			changes += "b" + vcdBinary(value) + " " + vcdIdentifier(i) + "\n";
+		} else {
+			changes += (value != 0 ? "1" : "0") + vcdIdentifier(i) + "\n";
+		}
+	}
+	if (!dumpStarted) {
+		changes = "$dumpvars\n" + changes + "bx " + vcdIdentifier(pins.size()) + "\n$end\n";
+	}
+	if (type == AUTOTEST_EVENT_ACTIVATE) {
+		changes += "b" + vcdBinary(value) + " " + vcdIdentifier(pins.size()) + "\n$comment " +
+				   (value < testCases.size() ? testCases[value].description : "test case " + std::to_string(value)) +
+				   " $end\n";
+	} else if (type == AUTOTEST_EVENT_PASS || type == AUTOTEST_EVENT_FAIL) {
+		changes += std::string("$comment ") + (type == AUTOTEST_EVENT_PASS ? "PASS " : "FAIL ") + std::to_string(value) +
+				   " $end\n";
+	}
+	if (changes.empty()) {
+		return;
+	}
+	//
+	// the time stamps in a dump cannot go back
+	//
+	if (!dumpStarted || lastTime > dumpTime) {
+		dumpTime = lastTime > dumpTime ? lastTime : dumpTime;
+		printf("#%llu\n", dumpTime);
+	}
+	dumpStarted = true;
+	fputs(changes.c_str(), stdout);
+}
+
+/**
+ * @name handleEvent(uint8_t type, uint8_t pin, unsigned long value)
+ * Updates the pin values and writes the event as CSV or to the dump
+ */
+static void handleEvent(uint8_t type, uint8_t pin, unsigned long value) {
+	updatePins(type, pin, value);
+	if (type == AUTOTEST_EVENT_ACTIVATE) {
+		activationTime = lastTime;
+	}
+	if (vcd) {
+		vcdEvent(type, value);
+	} else {
+		decodeEvent(type, pin, value);
+	}
+}
+
+/**
+ * @name decodeFrame(const uint8_t *frame)
+ * Decodes a fixed size frame of AUTOTEST_OUTPUT_BINARY
+ */
+static void decodeFrame(const uint8_t *frame) {
+	setTime(frame[5] | (frame[6] << 8) | ((unsigned long)frame[7] << 16) | ((unsigned long)frame[8] << 24));
+	if (frame[1] == AUTOTEST_EVENT_LATENCY) {
+		//
+		// the value in the frame stops at 0xFFFF, the time stamps do not
+		//
+		handleEvent(frame[1], frame[2], (unsigned long)(lastTime - activationTime));
+	} else if (frame[1] == AUTOTEST_EVENT_MISMATCH) {
+		handleEvent(frame[1], frame[2], ((unsigned long)frame[4] << 16) | frame[3]);
+	} else {
+		handleEvent(frame[1], frame[2], frame[3] | (frame[4] << 8));
+	}
+}
+
+/**
+ * @name getNumber(const uint8_t *&ptr, const uint8_t *end, unsigned long &number)
+ * @returns bool	false if the number does not end before end
+ * Reads a number sent in groups of 7 bits (AutoTest::putNumber())
+ */
+static bool getNumber(const uint8_t *&ptr, const uint8_t *end, unsigned long &number) {
+	number = 0;
+	for (uint8_t shift = 0; ptr < end && shift < 35; shift += 7) {
+		number |= (unsigned long)(*ptr & 0x7F) << shift;
+		if ((*ptr++ & 0x80) == 0) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @name decodeRecord(const uint8_t *record, size_t available, bool &complete)
+ * @returns size_t	length of the record or 0 if this is not a valid record
+ * Decodes a delta record or keyframe of AUTOTEST_OUTPUT_DELTA. complete is false if more bytes are needed to tell
+ */
+static size_t decodeRecord(const uint8_t *record, size_t available, bool &complete) {
+	const uint8_t			*ptr = record + 3;			// after sync, type and pin
+	const uint8_t			*end = record + available;
+	bool					keyframe = record[0] == AUTOTEST_KEYFRAME_SYNC;
+	std::vector<uint16_t>	values = pinValues;			// snapshot after this record
+	unsigned long			value;
+	unsigned long			number;
+	unsigned long			time;
+	uint8_t					check = 0;
+
+	complete = false;
+	if (available < 4 || !getNumber(ptr, end, value)) {
+		return 0;
+	}
+	if (keyframe) {
+		if (end - ptr < 6) {
+			return 0;
+		}
+		time = ptr[0] | (ptr[1] << 8) | ((unsigned long)ptr[2] << 16) | ((unsigned long)ptr[3] << 24);
+		ptr += 6;
+		for (size_t i = 0; i < values.size(); i++) {
+			if (!getNumber(ptr, end, number)) {
+				return 0;
+			}
+			values[i] = number;
+		}
+	} else {
+		const uint8_t *mask;						// one bit for each pin that changed
+
+		if (!getNumber(ptr, end, time)) {
+			return 0;
+		}
+		mask = ptr;
+		ptr += (values.size() + 7) / 8;
+		for (size_t i = 0; i < values.size() && ptr <= end; i++) {
+			if (mask[i / 8] & (1 << (i % 8))) {
+				if (!getNumber(ptr, end, number)) {
+					return 0;
+				}
+				values[i] = number;
+			}
+		}
+	}
+	if (ptr >= end) {
+		return 0;
+	}
+	complete = true;
+	for (const uint8_t *i = record; i < ptr; i++) {
+		check ^= *i;
+	}
+	if (check != *ptr) {
+		return 0;
+	}
+	//
+	// valid record. Delta records only mean something once a keyframe is known
+	//
+	if (keyframe) {
+		keyframeSeen = true;
+		setTime(time);
+	} else if (keyframeSeen) {
+		setTime((unsigned long)(lastTime + time));
+	} else {
+		return ptr + 1 - record;
+	}
+	pinValues = values;
+	handleEvent(record[1], record[2], value);
+	return ptr + 1 - record;
+}
+
+/**
+ * @name validFrame(const uint8_t *frame)
+ * @returns bool	true if the check byte matches
+ */
+static bool validFrame(const uint8_t *frame) {
+	uint8_t check = 0;
+
+	for (uint8_t i = 0; i < AUTOTEST_FRAME_LENGTH - 1; i++) {
+		check ^= frame[i];
+	}
+	return frame[0] == AUTOTEST_FRAME_SYNC && check == frame[AUTOTEST_FRAME_LENGTH - 1];
+}
+
+int main(int argc, char **argv) {
+	uint8_t		buffer[65536];				// bytes read from stdin
+	size_t		used = 0;					// number of bytes in buffer
+	size_t		length;						// bytes read in one go
+	std::string	error;						// why a header could not be read
+	std::string	analogNames;				// pins of -a separated by commas
+	int			arg = 1;
+
+	if (arg < argc && (strcmp(argv[arg], "-m") == 0 || strcmp(argv[arg], "-u") == 0)) {
+		timeField = argv[arg][1];
+		arg++;
+	} else if (arg < argc && strcmp(argv[arg], "-v") == 0) {
+		vcd = true;
+		arg++;
+		if (arg + 1 < argc && strcmp(argv[arg], "-a") == 0) {
+			analogNames = std::string(",") + argv[arg + 1] + ",";
+			arg += 2;
+		}
+	}
+	if (argc - arg != 2) {
+		fprintf(stderr, "usage: %s [-m | -u | -v [-a pin,...]] pinHeaders.h TestCases.h < trace > trace.csv\n", argv[0]);
+		return 2;
+	}
+	if (!loadPinHeaders(argv[arg], pins, error) || !loadTestCases(argv[arg + 1], -1, testCases, error)) {
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	pinValues.assign(pins.size(), 0);
+	dumpedValues.assign(pins.size(), 0);
+	analogWarned.assign(pins.size(), false);
+	for (size_t i = 0; i < pins.size(); i++) {
+		analogPins.push_back(analogNames.find("," + pins[i].name + ",") != std::string::npos);
+	}
+	if (vcd) {
+		vcdHeader();
+	}
+	//
+	// look for frames and records. Anything else is skipped one byte at a time
+	//
+	do {
+		size_t i = 0;
+
+		length = fread(buffer + used, 1, sizeof(buffer) - used, stdin);
+		used += length;
+		while (i < used) {
+			bool	complete = true;
+			size_t	recordLength = 0;
+
+			if (buffer[i] == AUTOTEST_FRAME_SYNC) {
+				complete = i + AUTOTEST_FRAME_LENGTH <= used;
+				if (complete && validFrame(buffer + i)) {
+					decodeFrame(buffer + i);
+					recordLength = AUTOTEST_FRAME_LENGTH;
+				}
+			} else if (buffer[i] == AUTOTEST_DELTA_SYNC || buffer[i] == AUTOTEST_KEYFRAME_SYNC) {
+				recordLength = decodeRecord(buffer + i, used - i, complete);
+			}
+			if (!complete && length > 0 && used - i < sizeof(buffer) / 2) {
+				break;							// read more before deciding
+			}
+			i += recordLength > 0 ? recordLength : 1;
+		}
+		memmove(buffer, buffer + i, used - i);
+		used -= i;
+	} while (length > 0);
+	if (!vcd) {
+		printf("\r\n");
+	}
+	return 0;
+}
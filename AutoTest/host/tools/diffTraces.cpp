@@ -0,0 +1,399 @@
+/**
+ * @file diffTraces.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Compares the output of a run against a known good run. Both files are mapped into memory and read once from
+ * start to end, so the memory used does not depend on their size. The traces can be the CSV of AUTOTEST_OUTPUT_CSV
+ * or the frames of AUTOTEST_OUTPUT_BINARY (found by their sync byte and check byte). Delta records cannot be read
+ * without the pin count, so run those through decodeTrace first.
+ *
+ * The events are lined up by test case number and by their index in the test case, so an extra or missing event
+ * only affects its own test case. The first difference is shown in full, followed by a summary of all of them.
+ *
+ * usage: diffTraces [-i fields] [-q] golden.csv run.csv
+ * \n -i	fields not compared, separated by commas. 1 is the first field, -1 the last (the extendSerialOut time for
+ * example). For frames the fields are type, pin, value and time
+ * \n -q	only the summary
+ *
+ * The exit code is 0 if the traces are the same, 1 if they differ and 2 if a file cannot be read.
+ */
+#include "AutoTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <string>
+#include <vector>
+
+#define MAX_FIELDS		64						// fields per event that are counted separately in the summary
+
+/**
+ * a field of an event
+ */
+struct Field {
+	const char	*text;
+	size_t		length;
+};
+
+/**
+ * an event of a trace: a line of CSV or a frame
+ */
+struct Event {
+	long				testCase;				// test case it belongs to. -1 before the first activation
+	unsigned long		index;					// number of the event in the test case
+	unsigned long		position;				// line number (CSV) or byte offset (frames)
+	const char			*text;					// the line. A frame is written out into buffer
+	size_t				length;
+	std::vector<Field>	fields;
+	char				buffer[64];				// text of a frame
+};
+
+/**
+ * a trace file
+ */
+struct Trace {
+	const char			*name;
+	const char			*data;					// the mapped file
+	size_t				size;
+	size_t				pos;					// next byte to read
+	bool				frames;					// binary frames instead of CSV
+	long				testCase;				// test case of the last event
+	unsigned long		index;					// index of the next event in that test case
+	unsigned long		line;					// line number of the next line
+	bool				latencyTable;			// in the rows of printLatencyStats()
+};
+
+static std::vector<long>	ignored;			// fields not compared
+static bool					quiet = false;
+
+/**
+ * @name openTrace(const char *name, Trace &trace)
+ * @returns bool	false if the file cannot be mapped
+ */
+static bool openTrace(const char *name, Trace &trace) {
+	int			file = open(name, O_RDONLY);
+	struct stat	info;
+
+	trace.name		= name;
+	trace.data		= NULL;
+	trace.size		= 0;
+	trace.pos		= 0;
+	trace.testCase	= -1;
+	trace.index		= 0;
+	trace.line		= 1;
+	trace.latencyTable = false;
+	if (file < 0 || fstat(file, &info) != 0) {
+		return false;
+	}
+	trace.size = info.st_size;
+	if (trace.size > 0) {
+		void *map = mmap(NULL, trace.size, PROT_READ, MAP_PRIVATE, file, 0);
+
+		if (map == MAP_FAILED) {
+			close(file);
+			return false;
+		}
+		madvise(map, trace.size, MADV_SEQUENTIAL);
+		trace.data = (const char *)map;
+	}
+	close(file);
+	//
+	// a trace with frames starts with a valid frame, usually at once but sketch output can come first
+	//
+	trace.frames = false;
+	for (size_t i = 0; i + AUTOTEST_FRAME_LENGTH <= trace.size && i < 4096; i++) {
+		const uint8_t	*frame = (const uint8_t *)trace.data + i;
+		uint8_t			check = 0;
+
+		for (uint8_t j = 0; j < AUTOTEST_FRAME_LENGTH - 1; j++) {
+			check ^= frame[j];
+		}
+		if (frame[0] == AUTOTEST_FRAME_SYNC && check == frame[AUTOTEST_FRAME_LENGTH - 1]) {
+			trace.frames = true;
+			break;
+		}
+	}
+	return true;
+}
+
+/**
+ * @name splitFields(Event &event)
+ * Splits the text of the event at the CSV separators
+ */
+static void splitFields(Event &event) {
+	const char	*start	= event.text;
+	const char	*end	= event.text + event.length;
+
+	event.fields.clear();
+	while (true) {
+		const char	*separator = (const char *)memchr(start, CSV_SEPARATOR[0], end - start);
+		Field		field;
+
+		field.text		= start;
+		field.length	= (separator == NULL ? end : separator) - start;
+		//
+		// displayPins() ends every line with a separator. That does not make another field
+		//
+		if (separator != NULL || field.length != 0) {
+			event.fields.push_back(field);
+		}
+		if (separator == NULL) {
+			break;
+		}
+		start = separator + 1;
+	}
+}
+
+/**
+ * @name isActivation(Trace &trace, const Event &event)
+ * @returns bool	true if the line is the one displayPins() sends when a test case is activated. All the other
+ * lines with pin values start with "pin " or "port ". The other lines with fields are the results of the checks,
+ * the TESTSET line of a prefix tree run and the latency table, whose rows come right after its header up to the next
+ * empty line
+ */
+static bool isActivation(Trace &trace, const Event &event) {
+	if (strncmp(event.text, "latency pin;", 12) == 0) {
+		trace.latencyTable = true;
+	}
+	return event.fields.size() > 1 && event.fields[0].length > 0 && !trace.latencyTable &&
+		   strncmp(event.text, "pin ", 4) != 0 && strncmp(event.text, "port ", 5) != 0 &&
+		   strncmp(event.text, "PASS;", 5) != 0 && strncmp(event.text, "FAIL;", 5) != 0 &&
+		   strncmp(event.text, "RESULT;", 7) != 0 && strncmp(event.text, "TESTSET;", 8) != 0;
+}
+
+/**
+ * @name nextLine(Trace &trace, Event &event)
+ * @returns bool	false at the end of the trace
+ */
+static bool nextLine(Trace &trace, Event &event) {
+	while (trace.pos < trace.size) {
+		const char	*start	= trace.data + trace.pos;
+		const char	*end	= (const char *)memchr(start, '\n', trace.size - trace.pos);
+		size_t		length	= (end == NULL ? trace.data + trace.size : end) - start;
+
+		trace.pos += length + 1;
+		event.position = trace.line++;
+		if (length > 0 && start[length - 1] == '\r') {
+			length--;
+		}
+		if (length == 0) {
+			trace.latencyTable = false;
+			continue;
+		}
+		event.text		= start;
+		event.length	= length;
+		splitFields(event);
+		if (isActivation(trace, event)) {
+			trace.testCase++;
+			trace.index = 0;
+		}
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @name nextFrame(Trace &trace, Event &event)
+ * @returns bool	false at the end of the trace
+ * Bytes that are not part of a valid frame are skipped like decodeTrace does
+ */
+static bool nextFrame(Trace &trace, Event &event) {
+	while (trace.pos + AUTOTEST_FRAME_LENGTH <= trace.size) {
+		const uint8_t	*frame = (const uint8_t *)trace.data + trace.pos;
+		uint8_t			check = 0;
+
+		for (uint8_t j = 0; j < AUTOTEST_FRAME_LENGTH - 1; j++) {
+			check ^= frame[j];
+		}
+		if (frame[0] != AUTOTEST_FRAME_SYNC || check != frame[AUTOTEST_FRAME_LENGTH - 1]) {
+			trace.pos++;
+			continue;
+		}
+		event.position	= trace.pos;
+		trace.pos		+= AUTOTEST_FRAME_LENGTH;
+		long testCase	= frame[9] | (frame[10] << 8);
+		if (testCase == 0xFFFF) {
+			testCase = -1;
+		}
+		if (testCase != trace.testCase) {
+			trace.testCase	= testCase;
+			trace.index		= 0;
+		}
+		event.length = snprintf(event.buffer, sizeof(event.buffer), "%u;%u;%u;%lu", frame[1], frame[2],
+								frame[3] | (frame[4] << 8), (unsigned long)frame[5] | ((unsigned long)frame[6] << 8) |
+								((unsigned long)frame[7] << 16) | ((unsigned long)frame[8] << 24));
+		event.text = event.buffer;
+		splitFields(event);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @name nextEvent(Trace &trace, Event &event)
+ * @returns bool	false at the end of the trace
+ */
+static bool nextEvent(Trace &trace, Event &event) {
+	if (!(trace.frames ? nextFrame(trace, event) : nextLine(trace, event))) {
+		return false;
+	}
+	event.testCase	= trace.testCase;
+	event.index		= trace.index++;
+	return true;
+}
+
+/**
+ * @name isIgnored(long field, size_t fields)
+ * @returns bool	true if field (0 based) of an event with fields fields is not compared
+ */
+static bool isIgnored(long field, size_t fields) {
+	for (size_t i = 0; i < ignored.size(); i++) {
+		if (ignored[i] == field + 1 || ignored[i] == field - (long)fields) {
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @name showEvent(const Trace &trace, const Event *event)
+ * Prints where an event is and its text
+ */
+static void showEvent(const Trace &trace, const Event *event) {
+	if (event == NULL) {
+		printf("  %s: no event\n", trace.name);
+	} else {
+		printf("  %s %s %lu: %.*s\n", trace.name, trace.frames ? "offset" : "line", event->position,
+			   (int)event->length, event->text);
+	}
+}
+
+int main(int argc, char **argv) {
+	Trace			golden;
+	Trace			run;
+	Event			goldenEvent;
+	Event			runEvent;
+	bool			haveGolden;
+	bool			haveRun;
+	bool			first = true;					// no difference shown yet
+	unsigned long	compared = 0;					// events in both traces
+	unsigned long	different = 0;					// of which not the same
+	unsigned long	missing = 0;					// events only in the golden trace
+	unsigned long	extra = 0;						// events only in the run
+	unsigned long	fieldCounts[MAX_FIELDS + 1] = { 0 };	// differences per field. The last one is for more fields
+	unsigned long	testCases = 0;					// test cases with a difference
+	long			lastTestCase = -2;				// test case of the last difference
+	int				arg = 1;
+
+	for (; arg < argc && argv[arg][0] == '-'; arg++) {
+		if (strcmp(argv[arg], "-q") == 0) {
+			quiet = true;
+		} else if (strcmp(argv[arg], "-i") == 0 && arg + 1 < argc) {
+			for (char *ptr = argv[++arg]; *ptr != '\0'; ) {
+				ignored.push_back(strtol(ptr, &ptr, 10));
+				if (*ptr == ',') {
+					ptr++;
+				} else if (*ptr != '\0') {
+					break;
+				}
+			}
+		} else {
+			break;
+		}
+	}
+	if (argc - arg != 2) {
+		fprintf(stderr, "usage: %s [-i fields] [-q] golden run\n", argv[0]);
+		return 2;
+	}
+	for (int i = 0; i < 2; i++) {
+		if (!openTrace(argv[arg + i], i == 0 ? golden : run)) {
+			fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[arg + i]);
+			return 2;
+		}
+	}
+	if (golden.frames != run.frames) {
+		fprintf(stderr, "%s: one trace has frames, the other CSV\n", argv[0]);
+		return 2;
+	}
+	haveGolden	= nextEvent(golden, goldenEvent);
+	haveRun		= nextEvent(run, runEvent);
+	while (haveGolden || haveRun) {
+		const Event	*left	= NULL;					// event of golden at this position
+		const Event	*right	= NULL;					// event of run at this position
+		bool		same	= true;
+
+		//
+		// line up on test case and index. The side that is behind has an event the other does not have
+		//
+		if (haveGolden && (!haveRun || goldenEvent.testCase < runEvent.testCase ||
+			(goldenEvent.testCase == runEvent.testCase && goldenEvent.index < runEvent.index))) {
+			left = &goldenEvent;
+			missing++;
+			same = false;
+		} else if (haveRun && (!haveGolden || runEvent.testCase < goldenEvent.testCase ||
+			(goldenEvent.testCase == runEvent.testCase && runEvent.index < goldenEvent.index))) {
+			right = &runEvent;
+			extra++;
+			same = false;
+		} else {
+			left	= &goldenEvent;
+			right	= &runEvent;
+			compared++;
+			for (size_t i = 0; i < left->fields.size() || i < right->fields.size(); i++) {
+				bool equal;
+
+				if (isIgnored(i, left->fields.size()) || isIgnored(i, right->fields.size())) {
+					continue;
+				}
+				equal = i < left->fields.size() && i < right->fields.size() &&
+						left->fields[i].length == right->fields[i].length &&
+						memcmp(left->fields[i].text, right->fields[i].text, left->fields[i].length) == 0;
+				if (!equal) {
+					fieldCounts[i < MAX_FIELDS ? i : MAX_FIELDS]++;
+					same = false;
+				}
+			}
+			if (!same) {
+				different++;
+			}
+		}
+		if (!same) {
+			long testCase = left != NULL ? left->testCase : right->testCase;
+
+			if (testCase != lastTestCase) {
+				testCases++;
+				lastTestCase = testCase;
+			}
+			if (first && !quiet) {
+				printf("first difference in test case %ld, event %lu:\n", testCase,
+					   left != NULL ? left->index : right->index);
+				showEvent(golden, left);
+				showEvent(run, right);
+			}
+			first = false;
+		}
+		if (left != NULL) {
+			haveGolden = nextEvent(golden, goldenEvent);
+		}
+		if (right != NULL) {
+			haveRun = nextEvent(run, runEvent);
+		}
+	}
+	//
+	// summary
+	//
+	printf("%lu events compared, %lu different, %lu missing, %lu extra, %lu test cases with differences\n",
+		   compared, different, missing, extra, testCases);
+	for (int i = 0; i <= MAX_FIELDS; i++) {
+		if (fieldCounts[i] != 0) {
+			printf("  field %d%s: %lu\n", i + 1, i == MAX_FIELDS ? " and later" : "", fieldCounts[i]);
+		}
+	}
+	return first ? 0 : 1;
+}
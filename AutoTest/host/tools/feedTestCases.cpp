@@ -0,0 +1,222 @@
+/**
+ * @file feedTestCases.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Sends test cases to a sketch built with AUTOTEST_STREAM_TEST_CASES. AutoTest sends AUTOTEST_STREAM_REQUEST each
+ * time it has room for a record and gets exactly one record per request, so it is never sent more than it can hold.
+ * After the last record an empty line ends the test set. The requests are taken out of the output of the sketch and
+ * the rest is passed on to stdout. In binary and delta mode AutoTest escapes the data bytes that look like a request
+ * (see AUTOTEST_STREAM_ESCAPE), which are restored here, so the output is the same as with the test cases in Flash.
+ * Text the sketch prints itself should not contain the escape byte.
+ *
+ * The sketch is either a host program (make STREAM=1) that is started with a pipe on its stdin and stdout, or a
+ * board on a serial port:
+ *
+ * usage: feedTestCases [-d device [-b baud] [-t seconds]] TestCases.h [program [arguments]]
+ * \n -d	serial port of the board. Without it the program is started
+ * \n -b	baud rate of the port (default 115200)
+ * \n -t	the run ends when the board sent nothing for this long after the end of the test set (default 2)
+ *
+ * The test cases can be a TestCases.h or a text file with one record per line. The exit code is that of the program.
+ */
+#include "headerFiles.h"
+#include "AutoTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <spawn.h>
+#include <termios.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+/**
+ * @name writeAll(int fd, const char *data, size_t length)
+ * @returns bool	false if the other side is gone
+ */
+static bool writeAll(int fd, const char *data, size_t length) {
+	while (length > 0) {
+		ssize_t written = write(fd, data, length);
+
+		if (written < 0 && errno == EINTR) {
+			continue;
+		}
+		if (written <= 0) {
+			return false;
+		}
+		data	+= written;
+		length	-= written;
+	}
+	return true;
+}
+
+/**
+ * @name openPort(const char *device, long baud)
+ * @returns int	file descriptor of the serial port in raw mode or -1
+ */
+static int openPort(const char *device, long baud) {
+	struct termios	settings;
+	speed_t			speed;
+	int				fd = open(device, O_RDWR | O_NOCTTY);
+
+	switch (baud) {
+	case 9600:		speed = B9600;		break;
+	case 19200:		speed = B19200;		break;
+	case 38400:		speed = B38400;		break;
+	case 57600:		speed = B57600;		break;
+	case 230400:	speed = B230400;	break;
+	default:		speed = B115200;
+	}
+	if (fd < 0 || tcgetattr(fd, &settings) != 0) {
+		return -1;
+	}
+	cfmakeraw(&settings);
+	cfsetispeed(&settings, speed);
+	cfsetospeed(&settings, speed);
+	settings.c_cflag |= CLOCAL | CREAD;
+	if (tcsetattr(fd, TCSANOW, &settings) != 0) {
+		close(fd);
+		return -1;
+	}
+	return fd;
+}
+
+int main(int argc, char **argv) {
+	std::string			source;					// the test case file
+	std::string			records;				// the records, one per line
+	size_t				next = 0;				// first byte of the next record to send
+	bool				ended = false;			// the empty record is sent
+	bool				escaped = false;		// the last byte was AUTOTEST_STREAM_ESCAPE
+	const char			*device = NULL;
+	long				baud = 115200;
+	long				quietTime = 2;			// seconds
+	int					toSketch;				// the records go here
+	int					fromSketch;				// and the output comes from here
+	pid_t				pid = 0;
+	int					status = 0;
+	int					arg = 1;
+
+	for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+		if (strcmp(argv[arg], "-d") == 0) {
+			device = argv[arg + 1];
+		} else if (strcmp(argv[arg], "-b") == 0) {
+			baud = atol(argv[arg + 1]);
+		} else if (strcmp(argv[arg], "-t") == 0) {
+			quietTime = atol(argv[arg + 1]);
+		} else {
+			break;
+		}
+	}
+	if (arg >= argc || (device == NULL && argc - arg < 2) || (device != NULL && argc - arg != 1)) {
+		fprintf(stderr, "usage: %s [-d device [-b baud] [-t seconds]] TestCases.h [program [arguments]]\n", argv[0]);
+		return 2;
+	}
+	if (!readFile(argv[arg], source)) {
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[arg]);
+		return 2;
+	}
+	//
+	// a header has the records in string literals, anything else is taken as it is
+	//
+	records = source.find('"') != std::string::npos ? stringLiterals(source) : source;
+	if (records.find("\n\n") != std::string::npos) {
+		records.erase(records.find("\n\n") + 1);
+	} else if (records.empty() || records[0] == '\n') {
+		records.clear();
+	} else if (records[records.size() - 1] != '\n') {
+		records += '\n';
+	}
+	signal(SIGPIPE, SIG_IGN);
+	if (device != NULL) {
+		toSketch = fromSketch = openPort(device, baud);
+		if (toSketch < 0) {
+			fprintf(stderr, "%s: cannot open %s\n", argv[0], device);
+			return 2;
+		}
+	} else {
+		posix_spawn_file_actions_t	actions;
+		int							input[2];		// records to the program
+		int							output[2];		// output of the program
+		int							error;
+
+		if (pipe(input) != 0 || pipe(output) != 0) {
+			fprintf(stderr, "%s: cannot create pipes\n", argv[0]);
+			return 2;
+		}
+		posix_spawn_file_actions_init(&actions);
+		posix_spawn_file_actions_adddup2(&actions, input[0], 0);
+		posix_spawn_file_actions_adddup2(&actions, output[1], 1);
+		posix_spawn_file_actions_addclose(&actions, input[1]);
+		posix_spawn_file_actions_addclose(&actions, output[0]);
+		error = posix_spawn(&pid, argv[arg + 1], &actions, NULL, &argv[arg + 1], environ);
+		posix_spawn_file_actions_destroy(&actions);
+		if (error != 0) {
+			fprintf(stderr, "%s: cannot start %s: %s\n", argv[0], argv[arg + 1], strerror(error));
+			return 2;
+		}
+		close(input[0]);
+		close(output[1]);
+		toSketch	= input[1];
+		fromSketch	= output[0];
+	}
+	//
+	// pass the output on and answer every request with a record
+	//
+	while (true) {
+		struct pollfd	pfd = { fromSketch, POLLIN, 0 };
+		char			buffer[65536];
+		ssize_t			length;
+		ssize_t			kept = 0;				// bytes of buffer that are not requests
+
+		if (poll(&pfd, 1, device != NULL && ended ? quietTime * 1000 : -1) == 0) {
+			break;								// the board is done
+		}
+		length = read(fromSketch, buffer, sizeof(buffer));
+		if (length < 0 && errno == EINTR) {
+			continue;
+		}
+		if (length <= 0) {
+			break;								// the program ended
+		}
+		for (ssize_t i = 0; i < length; i++) {
+			//
+			// a request can come between the escape byte and the byte it escapes
+			//
+			if ((uint8_t)buffer[i] != AUTOTEST_STREAM_REQUEST) {
+				if (escaped) {
+					buffer[kept++]	= buffer[i] ^ 0x20;
+					escaped			= false;
+				} else if ((uint8_t)buffer[i] == AUTOTEST_STREAM_ESCAPE) {
+					escaped = true;
+				} else {
+					buffer[kept++] = buffer[i];
+				}
+			} else if (next < records.size()) {
+				size_t end = records.find('\n', next) + 1;
+
+				writeAll(toSketch, records.c_str() + next, end - next);
+				next = end;
+			} else if (!ended) {
+				writeAll(toSketch, "\n", 1);
+				ended = true;
+			}
+		}
+		fwrite(buffer, 1, kept, stdout);
+		fflush(stdout);
+	}
+	if (device != NULL) {
+		close(toSketch);
+		return 0;
+	}
+	close(toSketch);
+	close(fromSketch);
+	waitpid(pid, &status, 0);
+	return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
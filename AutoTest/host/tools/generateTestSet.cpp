@@ -0,0 +1,366 @@
+/**
+ * @file generateTestSet.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Writes pinHeaders.h, TestCases.h and FieldLengths.h from a plain text test set, the same files generateTestSets.xls
+ * makes, so a test set can be kept in version control and generated in a build. Fields are separated by commas or,
+ * for a file saved from a spreadsheet, by tabs. Lines that are empty or start with # are skipped:
+ * \n pin,13,LED[,input]		a pin in the order of the pin table. The number of input pins is the number of input values.
+ * 							An output the sketch sets with analogWrite() is marked analog
+ * \n Button pressed,1,1200		a test case: description,input values...,delay[,check from,check to,expected values...]
+ * \n Warming up,r0:1023:2000,0	an input value can be a generator (see AUTOTEST_ANALOG_GENERATORS)
+ *
+ * All the pins come before the first test case. Pin numbers, names, descriptions and values are checked against the
+ * sizes AutoTest can hold. The pins that can get a value other than 0 or 1 are counted for NUMBER_OF_ANALOG_PINS:
+ * the analog outputs, the inputs with a value above 1 or a generator and the outputs with an expected value above 1.
+ * A header that is already up to date is not written again, so its time stamp only changes when the test set does.
+ *
+ * usage: generateTestSet [-p] testSet.csv outputFolder
+ * \n -p	also writes TestCaseRecords.h and TestCaseDescriptions.h for AUTOTEST_PACKED_TEST_CASES
+ */
+#include "headerFiles.h"
+#include "AutoTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <chrono>
+
+#define MAX_DESCRIPTION		25					// size of the description buffers in AutoTest without the '\0'
+#define MAX_VALUE			9999				// AutoTest reads a value in 4 characters
+#define MAX_DELAY			999999999UL			// and a delay or check time in 9
+
+/**
+ * @name splitLine(const char *line, size_t length, std::vector<std::string> &fields)
+ * Splits a line at the tabs if it has any, otherwise at the commas
+ */
+static void splitLine(const char *line, size_t length, std::vector<std::string> &fields) {
+	char		separator = memchr(line, '\t', length) != NULL ? '\t' : ',';
+	const char	*end = line + length;
+
+	fields.clear();
+	while (true) {
+		const char *next = (const char *)memchr(line, separator, end - line);
+
+		fields.push_back(std::string(line, (next == NULL ? end : next) - line));
+		if (next == NULL) {
+			break;
+		}
+		line = next + 1;
+	}
+}
+
+/**
+ * @name getNumber(const std::string &field, unsigned long maximum, unsigned long &number)
+ * @returns bool	false if the field is not a number from 0 to maximum
+ */
+static bool getNumber(const std::string &field, unsigned long maximum, unsigned long &number) {
+	char *end;
+
+	if (field.empty() || field[0] < '0' || field[0] > '9') {
+		return false;
+	}
+	number = strtoul(field.c_str(), &end, 10);
+	return *end == '\0' && number <= maximum;
+}
+
+/**
+ * @name checkGenerator(const std::string &field)
+ * @returns bool	true if the generator has a known letter and 3 numbers that fit in 16 bits
+ */
+static bool checkGenerator(const std::string &field) {
+	std::vector<std::string>	numbers;
+	unsigned long				number;
+
+	for (size_t from = 1, colon; ; from = colon + 1) {
+		colon = field.find(':', from);
+		numbers.push_back(field.substr(from, colon - from));
+		if (colon == std::string::npos) {
+			break;
+		}
+	}
+	if (numbers.size() != 3) {
+		return false;
+	}
+	for (size_t i = 0; i < numbers.size(); i++) {
+		if (!getNumber(numbers[i], 65535, number)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+/**
+ * @name at(unsigned long lineNumber)
+ * @returns std::string	start of an error message about this line
+ */
+static std::string at(unsigned long lineNumber) {
+	return "line " + std::to_string(lineNumber) + ": ";
+}
+
+/**
+ * @name parseTestSet(const std::string &source, std::vector<PinHeader> &pins, long &inputPins,
+ * 					  std::vector<TestCase> &testCases, std::vector<bool> &analog, std::string &error)
+ * @param analog	gets a flag per pin that is set if the pin can get a value other than 0 or 1
+ * @returns bool	false if the test set is not valid. error tells where and why
+ */
+static bool parseTestSet(const std::string &source, std::vector<PinHeader> &pins, long &inputPins,
+						 std::vector<TestCase> &testCases, std::vector<bool> &analog, std::string &error) {
+	std::vector<std::string>	fields;
+	bool						used[256] = { false };	// pin numbers already in the table
+	std::vector<size_t>			inputs;					// pin of each input value
+	std::vector<size_t>			outputs;				// pin of each expected value
+	size_t						start = 0;
+	unsigned long				lineNumber = 0;
+
+	inputPins = 0;
+	while (start < source.size()) {
+		const char	*line = source.c_str() + start;
+		size_t		end = source.find('\n', start);
+		size_t		length = (end == std::string::npos ? source.size() : end) - start;
+
+		lineNumber++;
+		start = end == std::string::npos ? source.size() : end + 1;
+		if (length > 0 && line[length - 1] == '\r') {
+			length--;
+		}
+		if (length == 0 || line[0] == '#') {
+			continue;
+		}
+		splitLine(line, length, fields);
+		for (size_t i = 0; i < fields.size(); i++) {
+			if (fields[i].find_first_of(",\"\\") != std::string::npos) {
+				error = at(lineNumber) + "field " + fields[i] + " has a comma, quote or backslash";
+				return false;
+			}
+		}
+		if (fields[0] == "pin" && testCases.empty()) {
+			//
+			// pin,number,name[,input]
+			//
+			PinHeader		header;
+			unsigned long	number;
+
+			if (fields.size() < 3 || fields.size() > 4 || (fields.size() == 4 && fields[3] != "input" &&
+				fields[3] != "output" && fields[3] != "analog" && !fields[3].empty())) {
+				error = at(lineNumber) + "a pin is pin,number,name[,input|output|analog]";
+				return false;
+			}
+			if (!getNumber(fields[1], 255, number) || used[number]) {
+				error = at(lineNumber) + "pin number " + fields[1] + " is not valid or used twice";
+				return false;
+			}
+			if (fields[2].empty() || fields[2].size() > 254) {
+				error = at(lineNumber) + "pin name must have 1 to 254 characters";
+				return false;
+			}
+			if (fields.size() == 4 && fields[3] == "input") {
+				inputs.push_back(pins.size());
+				inputPins++;
+			} else {
+				outputs.push_back(pins.size());
+			}
+			analog.push_back(fields.size() == 4 && fields[3] == "analog");
+			used[number]	= true;
+			header.pin		= number;
+			header.name		= fields[2];
+			pins.push_back(header);
+			if (pins.size() > 255) {
+				error = at(lineNumber) + "more than 255 pins";
+				return false;
+			}
+		} else {
+			//
+			// description,input values...,delay[,check from,check to,expected values...]
+			//
+			TestCase	testCase;
+			long		count = fields.size();
+
+			if (pins.empty()) {
+				error = at(lineNumber) + "the pins come before the test cases";
+				return false;
+			}
+			if (count != inputPins + 2 && (count < inputPins + 4 || count > inputPins + 4 + (long)pins.size() - inputPins)) {
+				error = at(lineNumber) + "a test case has " + std::to_string(inputPins + 2) + " fields, or " +
+						std::to_string(inputPins + 4) + " to " + std::to_string(pins.size() + 4) + " with expected values";
+				return false;
+			}
+			if (fields[0].empty() || fields[0].size() > MAX_DESCRIPTION) {
+				error = at(lineNumber) + "description must have 1 to " + std::to_string(MAX_DESCRIPTION) + " characters";
+				return false;
+			}
+			testCase.description = fields[0];
+			for (long i = 1; i <= inputPins; i++) {
+				unsigned long value;
+
+				if (isGenerator(fields[i])) {
+					if (!checkGenerator(fields[i])) {
+						error = at(lineNumber) + "generator " + fields[i] + " is not a letter with 3 numbers up to 65535"
+								" separated by :";
+						return false;
+					}
+					testCase.values.push_back(0);
+					testCase.generators.push_back(fields[i]);
+					analog[inputs[i - 1]] = true;
+					continue;
+				}
+				if (!getNumber(fields[i], MAX_VALUE, value)) {
+					error = at(lineNumber) + "input value " + fields[i] + " is not a number from 0 to " +
+							std::to_string(MAX_VALUE) + " or a generator";
+					return false;
+				}
+				testCase.values.push_back(value);
+				testCase.generators.push_back("");
+				if (value > 1) {
+					analog[inputs[i - 1]] = true;
+				}
+			}
+			testCase.checkFrom	= 0;
+			testCase.checkTo	= 0;
+			if (!getNumber(fields[inputPins + 1], MAX_DELAY, testCase.delay) || (count > inputPins + 2 &&
+				(!getNumber(fields[inputPins + 2], MAX_DELAY, testCase.checkFrom) ||
+				 !getNumber(fields[inputPins + 3], MAX_DELAY, testCase.checkTo)))) {
+				error = at(lineNumber) + "delay or check window is not a number of msec";
+				return false;
+			}
+			for (long i = inputPins + 4; i < count; i++) {
+				unsigned long value = AUTOTEST_DONT_CARE;
+
+				if (!fields[i].empty() && fields[i] != "x" && !getNumber(fields[i], MAX_VALUE, value)) {
+					error = at(lineNumber) + "expected value " + fields[i] + " is not a number, x or empty";
+					return false;
+				}
+				testCase.expected.push_back(value);
+				if (value > 1 && value != AUTOTEST_DONT_CARE) {
+					analog[outputs[i - inputPins - 4]] = true;
+				}
+			}
+			testCases.push_back(testCase);
+		}
+	}
+	if (testCases.empty()) {
+		error = "no test cases";
+		return false;
+	}
+	return true;
+}
+
+/**
+ * @name testCaseRecord(const TestCase &testCase)
+ * @returns std::string	the record of the test case in TestCases.h
+ */
+static std::string testCaseRecord(const TestCase &testCase) {
+	std::string record = testCase.description;
+
+	for (size_t i = 0; i < testCase.values.size(); i++) {
+		record += "," + (testCase.generators[i].empty() ? std::to_string(testCase.values[i]) : testCase.generators[i]);
+	}
+	record += "," + std::to_string(testCase.delay);
+	if (!testCase.expected.empty()) {
+		record += "," + std::to_string(testCase.checkFrom) + "," + std::to_string(testCase.checkTo);
+		for (size_t i = 0; i < testCase.expected.size(); i++) {
+			record += "," + (testCase.expected[i] == AUTOTEST_DONT_CARE ? "x" : std::to_string(testCase.expected[i]));
+		}
+	}
+	return record;
+}
+
+int main(int argc, char **argv) {
+	std::string				source;				// the test set
+	std::vector<PinHeader>	pins;
+	std::vector<TestCase>	testCases;
+	std::vector<bool>		analog;				// pins that can get a value other than 0 or 1
+	std::string				pinHeaders;			// contents of the headers
+	std::string				testCaseHeader;
+	std::string				fieldLengths;
+	std::string				records;
+	std::string				descriptions;
+	std::string				error;
+	std::string				folder;
+	const char				*name;				// test set file without its folder
+	long					inputPins;
+	size_t					fieldLength = 0;	// longest pin name
+	size_t					descriptionLength = 0;	// longest description
+	size_t					expectedValues = 0;	// most expected values in a test case
+	bool					packed = false;
+	bool					changed;
+	int						written = 0;		// headers that changed
+	int						arg = 1;
+	auto					start = std::chrono::steady_clock::now();
+
+	if (arg < argc && strcmp(argv[arg], "-p") == 0) {
+		packed = true;
+		arg++;
+	}
+	if (argc - arg != 2) {
+		fprintf(stderr, "usage: %s [-p] testSet.csv outputFolder\n", argv[0]);
+		return 2;
+	}
+	if (!readFile(argv[arg], source)) {
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[arg]);
+		return 1;
+	}
+	if (!parseTestSet(source, pins, inputPins, testCases, analog, error)) {
+		fprintf(stderr, "%s: %s: %s\n", argv[0], argv[arg], error.c_str());
+		return 1;
+	}
+	folder = std::string(argv[arg + 1]) + "/";
+	name = strrchr(argv[arg], '/') != NULL ? strrchr(argv[arg], '/') + 1 : argv[arg];
+	//
+	// the headers in the layout of generateTestSets.xls
+	//
+	pinHeaders = "/**\n * @file PinHeaders.h\n * this is a generated file from " + std::string(name) +
+				 " by generateTestSet\n * It contains all the used pins and definitions used\n */\n"
+				 "#ifndef PINHEADERS_H_\n#define PINHEADERS_H_\n";
+	for (size_t i = 0; i < pins.size(); i++) {
+		pinHeaders += "\"" + std::to_string(pins[i].pin) + "," + pins[i].name + "\\n\"\n";
+		fieldLength = pins[i].name.size() > fieldLength ? pins[i].name.size() : fieldLength;
+	}
+	pinHeaders += "\"\\n\"\n#endif // PINHEADERS_H_\n";
+
+	testCaseHeader = "/**\n * @file TestCases.h \n * \n * this is a generated file from " + std::string(name) +
+					 " by generateTestSet\n * It contains all the testcases of the test set\n */\n\n"
+					 "#ifndef TESTCASES_H_ \n#define TESTCASES_H_ \n";
+	for (size_t i = 0; i < testCases.size(); i++) {
+		testCaseHeader += "\"" + testCaseRecord(testCases[i]) + "\\n\"\n";
+		descriptionLength = testCases[i].description.size() > descriptionLength ? testCases[i].description.size() :
+							descriptionLength;
+		expectedValues = testCases[i].expected.size() > expectedValues ? testCases[i].expected.size() : expectedValues;
+	}
+	testCaseHeader += "\"\\n\"\n#endif // TESTCASES_H_\n";
+
+	fieldLengths = "/**\n * @file FieldLengths.h\n * \n * this is a generated file from " + std::string(name) +
+				   " by generateTestSet\n */\n\n#ifndef FIELD_LENGTHS_H_ \n#define FIELD_LENGTHS_H_ \n\n"
+				   "#define NUMBER_OF_PINS " + std::to_string(pins.size()) + "\n\n"
+				   "#define NUMBER_OF_INPUT_PINS " + std::to_string(inputPins) + "\n"
+				   "#define MAX_FIELD_LENGTH " + std::to_string(fieldLength + 1) + "\n"
+				   "#define MAX_DESCRIPTION_LENGTH " + std::to_string(descriptionLength + 1) + "\n"
+				   "#define MAX_EXPECTED_VALUES " + std::to_string(expectedValues) + "\n"
+				   "#define NUMBER_OF_ANALOG_PINS " + std::to_string(std::count(analog.begin(), analog.end(), true)) + "\n\n"
+				   "#endif  // FIELD_LENGTHS_H_\n";
+
+	if (packed && !packTestCases(testCases, inputPins, name, records, descriptions, error)) {
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	//
+	// only the headers that changed are written
+	//
+	const std::string	*contents[] = { &pinHeaders, &testCaseHeader, &fieldLengths, &records, &descriptions };
+	const char			*names[] = { "pinHeaders.h", "TestCases.h", "FieldLengths.h", "TestCaseRecords.h",
+									 "TestCaseDescriptions.h" };
+
+	for (int i = 0; i < (packed ? 5 : 3); i++) {
+		if (!writeFileIfChanged(folder + names[i], *contents[i], changed)) {
+			fprintf(stderr, "%s: cannot write %s%s\n", argv[0], folder.c_str(), names[i]);
+			return 1;
+		}
+		written += changed;
+	}
+	printf("%u pins, %u test cases, %d headers written in %ld msec\n", (unsigned)pins.size(), (unsigned)testCases.size(),
+		   written, (long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+	return 0;
+}
@@ -0,0 +1,343 @@
+/**
+ * @file headerFiles.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Reading the headers generated by generateTestSets.xls in the host tools. See headerFiles.h
+ */
+#include "headerFiles.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <map>
+
+/**
+ * @name readFile(const char *fileName, std::string &contents)
+ * @returns bool	true if the file could be read
+ */
+bool readFile(const char *fileName, std::string &contents) {
+	FILE	*file = fopen(fileName, "rb");
+	char	buffer[4096];
+	size_t	length;
+
+	if (file == NULL) {
+		return false;
+	}
+	while ((length = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		contents.append(buffer, length);
+	}
+	fclose(file);
+	return true;
+}
+
+/**
+ * @name stringLiterals(const std::string &source)
+ * @returns std::string	all C string literals in source concatenated like the compiler does
+ * Comments are skipped so a quote in a comment does not start a literal
+ */
+std::string stringLiterals(const std::string &source) {
+	std::string	result;
+	size_t		i = 0;
+
+	while (i < source.size()) {
+		if (source.compare(i, 2, "//") == 0) {
+			i = source.find('\n', i);
+		} else if (source.compare(i, 2, "/*") == 0) {
+			i = source.find("*/", i);
+			i = i == std::string::npos ? i : i + 2;
+		} else if (source[i] == '"') {
+			//
+			// copy the literal and translate the escapes the generator uses
+			//
+			for (i++; i < source.size() && source[i] != '"'; i++) {
+				if (source[i] == '\\' && i + 1 < source.size()) {
+					i++;
+					switch (source[i]) {
+					case 'n':	result += '\n';	break;
+					case 'r':	result += '\r';	break;
+					case 't':	result += '\t';	break;
+					case '0':	result += '\0';	break;
+					default:	result += source[i];
+					}
+				} else {
+					result += source[i];
+				}
+			}
+			i++;
+		} else {
+			i++;
+		}
+		if (i == std::string::npos) {
+			break;
+		}
+	}
+	return result;
+}
+
+/**
+ * @name defineValue(const std::string &source, const char *name)
+ * @returns long	value of #define name in source or -1 if it is not there
+ */
+long defineValue(const std::string &source, const char *name) {
+	std::string	define = std::string("#define ") + name;
+	size_t		i = source.find(define + " ");
+
+	if (i == std::string::npos) {
+		i = source.find(define + "\t");
+	}
+	if (i == std::string::npos) {
+		return -1;
+	}
+	return strtol(source.c_str() + i + define.size(), NULL, 10);
+}
+
+/**
+ * @name cString(const std::string &text)
+ * @returns std::string	text with the characters escaped that cannot be in a C string literal
+ */
+std::string cString(const std::string &text) {
+	std::string result;
+
+	for (size_t i = 0; i < text.size(); i++) {
+		if (text[i] == '"' || text[i] == '\\') {
+			result += '\\';
+		}
+		result += text[i];
+	}
+	return result;
+}
+
+/**
+ * @name splitRecords(const std::string &csv, std::vector<std::vector<std::string> > &records)
+ * Splits the CSV into records of fields. Like in AutoTest an empty record ends the list
+ */
+static void splitRecords(const std::string &csv, std::vector<std::vector<std::string> > &records) {
+	size_t start = 0;
+
+	while (start < csv.size()) {
+		size_t		end = csv.find('\n', start);
+		std::string	record = csv.substr(start, end - start);
+
+		if (end == std::string::npos || record.empty()) {
+			break;
+		}
+		records.push_back(std::vector<std::string>());
+		for (size_t from = 0, comma; ; from = comma + 1) {
+			comma = record.find(',', from);
+			records.back().push_back(record.substr(from, comma - from));
+			if (comma == std::string::npos) {
+				break;
+			}
+		}
+		start = end + 1;
+	}
+}
+
+/**
+ * @name isGenerator(const std::string &field)
+ * @returns bool	true if the input field is a generator (see AUTOTEST_ANALOG_GENERATORS) instead of a value
+ */
+bool isGenerator(const std::string &field) {
+	return !field.empty() && std::string("rsqtn").find(field[0]) != std::string::npos;
+}
+
+/**
+ * @name parsePinHeaders(const std::string &csv, std::vector<PinHeader> &pins, std::string &error)
+ * @returns bool	false if a record is not valid. error tells why
+ */
+bool parsePinHeaders(const std::string &csv, std::vector<PinHeader> &pins, std::string &error) {
+	std::vector<std::vector<std::string> > records;
+
+	splitRecords(csv, records);
+	for (size_t i = 0; i < records.size(); i++) {
+		PinHeader	header;
+		char		*end;
+
+		if (records[i].size() != 2) {
+			error = "pin record " + std::to_string(i) + " must be pin,name";
+			return false;
+		}
+		header.pin	= strtoul(records[i][0].c_str(), &end, 10);
+		header.name	= records[i][1];
+		if (*end != '\0' || records[i][0].empty() || header.pin > 255) {
+			error = "pin record " + std::to_string(i) + " has an invalid pin number " + records[i][0];
+			return false;
+		}
+		pins.push_back(header);
+	}
+	return true;
+}
+
+/**
+ * @name parseTestCases(const std::string &csv, long inputPins, std::vector<TestCase> &testCases, std::string &error)
+ * @param inputPins	number of input values in each record. If < 0 it is not checked and only the descriptions are read
+ * @returns bool	false if a record is not valid. error tells why
+ */
+bool parseTestCases(const std::string &csv, long inputPins, std::vector<TestCase> &testCases, std::string &error) {
+	std::vector<std::vector<std::string> > records;
+
+	splitRecords(csv, records);
+	for (size_t i = 0; i < records.size(); i++) {
+		TestCase testCase;
+
+		testCase.description	= records[i][0];
+		testCase.delay			= 0;
+		testCase.checkFrom		= 0;
+		testCase.checkTo		= 0;
+		if (inputPins >= 0) {
+			long fields = records[i].size();
+
+			if (fields != inputPins + 2 && fields < inputPins + 4) {
+				error = "test case " + std::to_string(i) + " \"" + testCase.description + "\" has " +
+						std::to_string(fields) + " fields, expected " + std::to_string(inputPins + 2) +
+						" or at least " + std::to_string(inputPins + 4) + " with expected values";
+				return false;
+			}
+			for (long j = 1; j <= inputPins; j++) {
+				const std::string &field = records[i][j];
+
+				testCase.values.push_back(strtoul(field.c_str() + isGenerator(field), NULL, 10));
+				testCase.generators.push_back(isGenerator(field) ? field : "");
+			}
+			testCase.delay = strtoul(records[i][inputPins + 1].c_str(), NULL, 10);
+			//
+			// check window and expected values like AutoTest::getTestCase() reads them
+			//
+			if (fields > inputPins + 2) {
+				testCase.checkFrom	= strtoul(records[i][inputPins + 2].c_str(), NULL, 10);
+				testCase.checkTo	= strtoul(records[i][inputPins + 3].c_str(), NULL, 10);
+				for (long j = inputPins + 4; j < fields; j++) {
+					const std::string &field = records[i][j];
+
+					testCase.expected.push_back(!field.empty() && field[0] >= '0' && field[0] <= '9' ?
+												strtoul(field.c_str(), NULL, 10) : 0xFFFF);
+				}
+			}
+		}
+		testCases.push_back(testCase);
+	}
+	return true;
+}
+
+/**
+ * @name loadPinHeaders(const char *fileName, std::vector<PinHeader> &pins, std::string &error)
+ * @returns bool	false if the file cannot be read or is not valid
+ */
+bool loadPinHeaders(const char *fileName, std::vector<PinHeader> &pins, std::string &error) {
+	std::string source;
+
+	if (!readFile(fileName, source)) {
+		error = std::string("cannot read ") + fileName;
+		return false;
+	}
+	return parsePinHeaders(stringLiterals(source), pins, error);
+}
+
+/**
+ * @name loadTestCases(const char *fileName, long inputPins, std::vector<TestCase> &testCases, std::string &error)
+ * @returns bool	false if the file cannot be read or is not valid
+ */
+bool loadTestCases(const char *fileName, long inputPins, std::vector<TestCase> &testCases, std::string &error) {
+	std::string source;
+
+	if (!readFile(fileName, source)) {
+		error = std::string("cannot read ") + fileName;
+		return false;
+	}
+	return parseTestCases(stringLiterals(source), inputPins, testCases, error);
+}
+
+/**
+ * @name writeFileIfChanged(const std::string &fileName, const std::string &contents, bool &changed)
+ * @returns bool	false if the file cannot be written
+ * A file that already has these contents is left alone, so its time stamp does not make the sketch build again
+ */
+bool writeFileIfChanged(const std::string &fileName, const std::string &contents, bool &changed) {
+	std::string	old;
+	FILE		*file;
+
+	changed = !readFile(fileName.c_str(), old) || old != contents;
+	if (!changed) {
+		return true;
+	}
+	file = fopen(fileName.c_str(), "wb");
+	if (file == NULL) {
+		return false;
+	}
+	if (fwrite(contents.data(), 1, contents.size(), file) != contents.size()) {
+		fclose(file);
+		return false;
+	}
+	return fclose(file) == 0;
+}
+
+/**
+ * @name packTestCases(const std::vector<TestCase> &testCases, long inputPins, const std::string &source,
+ * 					   std::string &records, std::string &descriptions, std::string &error)
+ * @param source	name of the file the test cases came from, mentioned in the generated files
+ * @returns bool	false if the test cases do not fit in the packed format. error tells why
+ * A record has no room for generators or expected values, so test cases with them are refused rather than run
+ * without their checks.
+ * Makes the contents of TestCaseRecords.h (delay low word, delay high word, description offset, input values) and
+ * TestCaseDescriptions.h (every different description once, terminated with '\0')
+ */
+bool packTestCases(const std::vector<TestCase> &testCases, long inputPins, const std::string &source,
+				   std::string &records, std::string &descriptions, std::string &error) {
+	std::string						pool;				// all the descriptions
+	std::map<std::string, size_t>	poolOffsets;		// offset of each description in pool
+	char							words[64];
+
+	snprintf(words, sizeof(words), "%ld", inputPins);
+	records = "/**\n * @file TestCaseRecords.h\n *\n * this is a generated file from " + source + " by packTestCases\n"
+			  " * record: delay low word, delay high word, description offset, " + words + " input values\n */\n\n"
+			  "#ifndef TESTCASERECORDS_H_\n#define TESTCASERECORDS_H_\n";
+	for (size_t i = 0; i < testCases.size(); i++) {
+		//
+		// the same description is only stored once
+		//
+		if (poolOffsets.find(testCases[i].description) == poolOffsets.end()) {
+			poolOffsets[testCases[i].description] = pool.size();
+			pool += testCases[i].description;
+			pool += '\0';
+			if (pool.size() > 0x10000) {
+				error = "descriptions exceed 64K";
+				return false;
+			}
+		}
+		snprintf(words, sizeof(words), "0x%04lX, 0x%04lX, %5u,", testCases[i].delay & 0xFFFF,
+				 (testCases[i].delay >> 16) & 0xFFFF, (unsigned)poolOffsets[testCases[i].description]);
+		records += words;
+		if (!testCases[i].expected.empty()) {
+			error = "test case " + std::to_string(i) + " has expected values which cannot be packed";
+			return false;
+		}
+		for (long j = 0; j < inputPins; j++) {
+			if (!testCases[i].generators[j].empty()) {
+				error = "test case " + std::to_string(i) + " has generator " + testCases[i].generators[j] +
+						" which cannot be packed";
+				return false;
+			}
+			if (testCases[i].values[j] > 0xFFFF) {
+				error = "test case " + std::to_string(i) + " value " + std::to_string(testCases[i].values[j]) +
+						" out of range";
+				return false;
+			}
+			snprintf(words, sizeof(words), " %lu,", testCases[i].values[j]);
+			records += words;
+		}
+		records += "\t// " + testCases[i].description + "\n";
+	}
+	records += "#endif // TESTCASERECORDS_H_\n";
+	//
+	// and the descriptions
+	//
+	descriptions = "/**\n * @file TestCaseDescriptions.h\n *\n * this is a generated file from " + source +
+				   " by packTestCases\n */\n\n#ifndef TESTCASEDESCRIPTIONS_H_\n#define TESTCASEDESCRIPTIONS_H_\n";
+	for (size_t i = 0; i < pool.size(); i += strlen(pool.c_str() + i) + 1) {
+		descriptions += "\"" + cString(pool.c_str() + i) + "\\0\"\n";
+	}
+	descriptions += "#endif // TESTCASEDESCRIPTIONS_H_\n";
+	return true;
+}
@@ -0,0 +1,56 @@
+/**
+ * @file headerFiles.h
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Reading the headers generated by generateTestSets.xls in the host tools. The headers contain C string literals
+ * with the same CSV records AutoTest reads from Flash:
+ * \n pinHeaders.h		pin number,pin name
+ * \n TestCases.h		description,input values...,delay[,check from,check to,expected output values...]
+ * \n FieldLengths.h	the #defines with the sizes
+ *
+ * The writers produce the same files (and the packed records of AUTOTEST_PACKED_TEST_CASES) so packTestCases and
+ * generateTestSet give the same result.
+ */
+
+#ifndef HEADERFILES_H_
+#define HEADERFILES_H_
+
+#include <string>
+#include <vector>
+
+/**
+ * pin from pinHeaders.h
+ */
+struct PinHeader {
+	unsigned int	pin;					// pin number on the Arduino
+	std::string		name;					// name shown in the output
+};
+
+/**
+ * test case from TestCases.h
+ */
+struct TestCase {
+	std::string					description;	// shown in the output when the test case is activated
+	std::vector<unsigned long>	values;			// value for each input pin
+	std::vector<std::string>	generators;		// generator field for each input pin, empty if it has a fixed value
+	unsigned long				delay;			// msec before the test case is activated
+	unsigned long				checkFrom;		// msec after activation the expected values are checked
+	unsigned long				checkTo;		// end of the check window
+	std::vector<unsigned long>	expected;		// expected value for each output pin. 0xFFFF is not checked
+};
+
+bool			readFile(const char *fileName, std::string &contents);
+std::string		stringLiterals(const std::string &source);
+long			defineValue(const std::string &source, const char *name);
+std::string		cString(const std::string &text);
+bool			isGenerator(const std::string &field);
+bool			parsePinHeaders(const std::string &csv, std::vector<PinHeader> &pins, std::string &error);
+bool			parseTestCases(const std::string &csv, long inputPins, std::vector<TestCase> &testCases, std::string &error);
+bool			loadPinHeaders(const char *fileName, std::vector<PinHeader> &pins, std::string &error);
+bool			loadTestCases(const char *fileName, long inputPins, std::vector<TestCase> &testCases, std::string &error);
+bool			writeFileIfChanged(const std::string &fileName, const std::string &contents, bool &changed);
+bool			packTestCases(const std::vector<TestCase> &testCases, long inputPins, const std::string &source,
+							  std::string &records, std::string &descriptions, std::string &error);
+
+#endif /* HEADERFILES_H_ */
@@ -0,0 +1,62 @@
+/**
+ * @file packTestCases.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Converts the TestCases.h generated by generateTestSets.xls into packed binary test cases:
+ * \n TestCaseRecords.h		one record of AUTOTEST_PACKED_RECORD_WORDS words per test case
+ * \n TestCaseDescriptions.h	all the different descriptions, each terminated with '\0'
+ *
+ * AutomaticTesting.h uses these files instead of TestCases.h when the sketch defines AUTOTEST_PACKED_TEST_CASES.
+ * AutoTest then loads a test case with a few direct reads instead of scanning and converting text.
+ *
+ * usage: packTestCases TestCases.h FieldLengths.h outputFolder
+ */
+#include "headerFiles.h"
+
+#include <stdio.h>
+#include <string.h>
+
+int main(int argc, char **argv) {
+	std::string				fieldLengthsSource;	// contents of FieldLengths.h
+	std::vector<TestCase>	testCases;			// the test cases from TestCases.h
+	std::string				records;			// contents of TestCaseRecords.h
+	std::string				descriptions;		// contents of TestCaseDescriptions.h
+	std::string				error;				// why a file could not be read
+	long					inputPins;			// number of input values per test case
+	bool					changed;
+
+	if (argc != 4) {
+		fprintf(stderr, "usage: %s TestCases.h FieldLengths.h outputFolder\n", argv[0]);
+		return 2;
+	}
+	if (!readFile(argv[2], fieldLengthsSource)) {
+		fprintf(stderr, "%s: cannot read %s\n", argv[0], argv[2]);
+		return 1;
+	}
+	inputPins = defineValue(fieldLengthsSource, "NUMBER_OF_INPUT_PINS");
+	if (inputPins < 0) {
+		fprintf(stderr, "%s: NUMBER_OF_INPUT_PINS not found in %s\n", argv[0], argv[2]);
+		return 1;
+	}
+	if (!loadTestCases(argv[1], inputPins, testCases, error)) {
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	if (testCases.empty()) {
+		fprintf(stderr, "%s: no test cases in %s\n", argv[0], argv[1]);
+		return 1;
+	}
+	if (!packTestCases(testCases, inputPins, argv[1], records, descriptions, error)) {
+		fprintf(stderr, "%s: %s\n", argv[0], error.c_str());
+		return 1;
+	}
+	if (!writeFileIfChanged(std::string(argv[3]) + "/TestCaseRecords.h", records, changed) ||
+		!writeFileIfChanged(std::string(argv[3]) + "/TestCaseDescriptions.h", descriptions, changed)) {
+		fprintf(stderr, "%s: cannot write to %s\n", argv[0], argv[3]);
+		return 1;
+	}
+	printf("%u test cases, %u bytes of records\n", (unsigned)testCases.size(),
+		   (unsigned)(testCases.size() * (inputPins + 3) * 2));
+	return 0;
+}
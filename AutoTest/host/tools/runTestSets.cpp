@@ -0,0 +1,243 @@
+/**
+ * @file runTestSets.cpp
+ *
+ *  Created on	: 16 okt. 2026
+ *
+ * Runs a sketch built with make FILES=1 against many test set folders at the same time. A sketch keeps its state in
+ * globals, so every test set runs in its own process with its own pins, clock and output file.
+ *
+ * Each worker thread starts with an equal share of the test sets. It takes the next one from the front of its own
+ * list and, when that is empty, steals from the back of the list of another worker. A few slow test sets therefore
+ * do not keep one core busy while the others wait.
+ *
+ * usage: runTestSets [-j jobs] [-t seconds] [-o outputFolder] program testSetFolder...
+ * \n -j	number of test sets run at the same time (default: number of cores)
+ * \n -t	a test set that runs longer is stopped (default 60)
+ * \n -o	folder for the output of each test set and summary.csv (default results)
+ *
+ * The output of a test set goes to outputFolder/<test set folder with / replaced by _>.csv. When all are done the
+ * results are merged into summary.csv (test set;result;msec;bytes) in the order of the command line and printed.
+ * The exit code is 0 if every test set ended normally.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern char **environ;
+
+/**
+ * one test set and how it went
+ */
+struct Job {
+	std::string	folder;							// test set folder
+	std::string	outputFile;						// where its output goes
+	std::string	result;							// ok, exit n, signal n, timeout or the reason it did not start
+	long		msec;							// run time
+	long		bytes;							// size of the output
+};
+
+/**
+ * list of jobs of one worker
+ */
+struct Worker {
+	std::deque<size_t>	jobs;					// index in the job list
+	std::mutex			lock;
+};
+
+static std::vector<Job>		jobList;
+static std::vector<Worker>	workers;
+static std::string			program;			// the sketch
+static long					timeLimit = 60;		// seconds
+
+/**
+ * @name nextJob(size_t self, size_t &job)
+ * @returns bool	false if there is no work left
+ * Takes a job from the front of the own list or steals one from the back of another list
+ */
+static bool nextJob(size_t self, size_t &job) {
+	for (size_t i = 0; i < workers.size(); i++) {
+		Worker						&worker = workers[(self + i) % workers.size()];
+		std::lock_guard<std::mutex>	guard(worker.lock);
+
+		if (!worker.jobs.empty()) {
+			if (i == 0) {
+				job = worker.jobs.front();
+				worker.jobs.pop_front();
+			} else {
+				job = worker.jobs.back();
+				worker.jobs.pop_back();
+			}
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * @name runJob(Job &job)
+ * Starts the sketch for one test set and waits until it ends or runs out of time
+ */
+static void runJob(Job &job) {
+	posix_spawn_file_actions_t	actions;
+	pid_t						pid;
+	int							status = 0;
+	int							error;
+	char						*argv[] = { (char *)program.c_str(), (char *)job.folder.c_str(), NULL };
+	auto						start = std::chrono::steady_clock::now();
+	struct stat					info;
+
+	//
+	// the sketch polls Serial input, so it gets /dev/null instead of the terminal
+	//
+	posix_spawn_file_actions_init(&actions);
+	posix_spawn_file_actions_addopen(&actions, 0, "/dev/null", O_RDONLY, 0);
+	posix_spawn_file_actions_addopen(&actions, 1, job.outputFile.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	error = posix_spawn(&pid, program.c_str(), &actions, NULL, argv, environ);
+	if (error != 0) {
+		job.result = std::string("cannot start: ") + strerror(error);
+		posix_spawn_file_actions_destroy(&actions);
+		return;
+	}
+	posix_spawn_file_actions_destroy(&actions);
+	//
+	// wait for it, but not forever
+	//
+	while (waitpid(pid, &status, WNOHANG) == 0) {
+		if (std::chrono::steady_clock::now() - start > std::chrono::seconds(timeLimit)) {
+			kill(pid, SIGKILL);
+			waitpid(pid, &status, 0);
+			job.result = "timeout";
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	job.msec = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+	job.bytes = stat(job.outputFile.c_str(), &info) == 0 ? (long)info.st_size : 0;
+	if (!job.result.empty()) {
+		return;
+	}
+	if (WIFEXITED(status)) {
+		job.result = WEXITSTATUS(status) == 0 ? "ok" : "exit " + std::to_string(WEXITSTATUS(status));
+	} else if (WIFSIGNALED(status)) {
+		job.result = "signal " + std::to_string(WTERMSIG(status));
+	}
+}
+
+/**
+ * @name work(size_t self)
+ * Thread function of worker self
+ */
+static void work(size_t self) {
+	size_t job;
+
+	while (nextJob(self, job)) {
+		runJob(jobList[job]);
+	}
+}
+
+int main(int argc, char **argv) {
+	unsigned int	jobs = std::thread::hardware_concurrency();	// test sets at the same time
+	std::string		outputFolder = "results";
+	std::string		summaryFile;
+	FILE			*summary;
+	int				failed = 0;							// test sets that did not end normally
+	int				arg = 1;
+	std::vector<std::thread> threads;
+	auto			start = std::chrono::steady_clock::now();
+
+	for (; arg + 1 < argc && argv[arg][0] == '-'; arg += 2) {
+		if (strcmp(argv[arg], "-j") == 0) {
+			jobs = atoi(argv[arg + 1]);
+		} else if (strcmp(argv[arg], "-t") == 0) {
+			timeLimit = atol(argv[arg + 1]);
+		} else if (strcmp(argv[arg], "-o") == 0) {
+			outputFolder = argv[arg + 1];
+		} else {
+			break;
+		}
+	}
+	if (argc - arg < 2 || (argv[arg][0] == '-')) {
+		fprintf(stderr, "usage: %s [-j jobs] [-t seconds] [-o outputFolder] program testSetFolder...\n", argv[0]);
+		return 2;
+	}
+	if (jobs == 0) {
+		jobs = 1;
+	}
+	program = argv[arg++];
+	if (mkdir(outputFolder.c_str(), 0755) != 0 && errno != EEXIST) {
+		fprintf(stderr, "%s: cannot create %s\n", argv[0], outputFolder.c_str());
+		return 1;
+	}
+	//
+	// one job per test set, handed out round robin
+	//
+	for (; arg < argc; arg++) {
+		Job			job;
+		std::string	name = argv[arg];
+
+		while (name.size() > 1 && name[name.size() - 1] == '/') {
+			name.erase(name.size() - 1);
+		}
+		job.folder = name;
+		for (size_t i = 0; i < name.size(); i++) {
+			if (name[i] == '/') {
+				name[i] = '_';
+			}
+		}
+		job.outputFile	= outputFolder + "/" + name + ".csv";
+		job.msec		= 0;
+		job.bytes		= 0;
+		jobList.push_back(job);
+	}
+	if (jobs > jobList.size()) {
+		jobs = jobList.size();
+	}
+	workers = std::vector<Worker>(jobs);
+	for (size_t i = 0; i < jobList.size(); i++) {
+		workers[i % jobs].jobs.push_back(i);
+	}
+	for (size_t i = 0; i < jobs; i++) {
+		threads.push_back(std::thread(work, i));
+	}
+	for (size_t i = 0; i < threads.size(); i++) {
+		threads[i].join();
+	}
+	//
+	// merge the results
+	//
+	summaryFile = outputFolder + "/summary.csv";
+	summary = fopen(summaryFile.c_str(), "w");
+	if (summary == NULL) {
+		fprintf(stderr, "%s: cannot write %s\n", argv[0], summaryFile.c_str());
+		return 1;
+	}
+	fprintf(summary, "test set;result;msec;bytes\n");
+	printf("test set;result;msec;bytes\n");
+	for (size_t i = 0; i < jobList.size(); i++) {
+		fprintf(summary, "%s;%s;%ld;%ld\n", jobList[i].folder.c_str(), jobList[i].result.c_str(), jobList[i].msec,
+				jobList[i].bytes);
+		printf("%s;%s;%ld;%ld\n", jobList[i].folder.c_str(), jobList[i].result.c_str(), jobList[i].msec,
+			   jobList[i].bytes);
+		if (jobList[i].result != "ok") {
+			failed++;
+		}
+	}
+	fclose(summary);
+	fprintf(stderr, "%u test sets, %d failed, %u jobs, %ld msec\n", (unsigned)jobList.size(), failed, jobs,
+			(long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count());
+	return failed == 0 ? 0 : 1;
+}